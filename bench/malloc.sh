@@ -0,0 +1,19 @@
+#!/bin/bash
+# Build bench/malloc_bench.cpp against both allocators of eosiolib/malloc.cpp and run them.
+# Host compilers lack CDT's libc, which declares int128_t and the mem* functions,
+# and do not know the eosio_wasm_import attribute.
+set -e
+cd "$(dirname "$0")/.."
+CXX=${CXX:-c++}
+FLAGS="-std=c++17 -O2 -Wall -Wextra -Wno-attributes -DEOSIO_NATIVE -Dint128_t=__int128 -Duint128_t=__uint128_t -include cstring -I eosiolib"
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+$CXX $FLAGS -o "$OUT/first_fit" bench/malloc_bench.cpp eosiolib/malloc.cpp
+$CXX $FLAGS -DEOSIO_MALLOC_SIZE_CLASSES -o "$OUT/size_classes" bench/malloc_bench.cpp eosiolib/malloc.cpp
+
+echo "memory_manager (first fit)"
+"$OUT/first_fit"
+echo
+echo "size_class_manager (EOSIO_MALLOC_SIZE_CLASSES)"
+"$OUT/size_classes"
@@ -0,0 +1,152 @@
+/**
+ * Allocation-heavy workloads for the eosiolib allocators.
+ *
+ * Linked against eosiolib/malloc.cpp, which replaces malloc, realloc and
+ * free for the whole process. Run through bench/malloc.sh to compare the
+ * first-fit memory_manager with the size-class allocator.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+   // linear memory backing the native build of malloc.cpp
+   static char* heap_base() {
+      static char* base = static_cast<char*>(aligned_alloc(65536, size_t(1) << 30));
+      return base;
+   }
+   static size_t heap_pages = 1;
+
+   uintptr_t __get_heap_base() { return reinterpret_cast<uintptr_t>(heap_base()); }
+   size_t _current_memory() { return heap_pages; }
+   size_t _grow_memory(size_t pages) {
+      if ((heap_pages + pages) * 65536 > (size_t(1) << 30))
+         return size_t(-1);
+      size_t prev = heap_pages;
+      heap_pages += pages;
+      return prev;
+   }
+
+   // malloc.cpp only needs these for its checks
+   void eosio_assert(uint32_t test, const char* msg) {
+      if (!test) {
+         fprintf(stderr, "assertion failure: %s\n", msg);
+         abort();
+      }
+   }
+   void eosio_assert_message(uint32_t test, const char* msg, uint32_t len) {
+      if (!test) {
+         fprintf(stderr, "assertion failure: %.*s\n", int(len), msg);
+         abort();
+      }
+   }
+   void eosio_assert_code(uint32_t test, uint64_t code) {
+      if (!test) {
+         fprintf(stderr, "assertion failure with code %llu\n", (unsigned long long)code);
+         abort();
+      }
+   }
+}
+
+namespace {
+   // xorshift, so that both allocators see the same sequence
+   struct rng {
+      uint64_t s = 0x9e3779b97f4a7c15;
+      uint64_t operator()() {
+         s ^= s << 13;
+         s ^= s >> 7;
+         s ^= s << 17;
+         return s;
+      }
+   };
+
+   template<typename F>
+   void run(const char* name, uint64_t ops, F&& f) {
+      auto start = std::chrono::steady_clock::now();
+      uint64_t check = f();
+      double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      printf("%-10s %10.1f ns/op  (%llu)\n", name, ns / ops, (unsigned long long)check);
+   }
+
+   // short lived strings: replace a random slot of a live set with a new 8-256 byte buffer
+   uint64_t churn(uint64_t ops, size_t live) {
+      rng r;
+      std::vector<char*> slots(live, nullptr);
+      uint64_t sum = 0;
+      for (uint64_t i = 0; i < ops; i++) {
+         char*& slot = slots[r() % live];
+         free(slot);
+         size_t size = 8 + r() % 249;
+         slot = static_cast<char*>(malloc(size));
+         slot[0] = char(size);
+         sum += uint8_t(slot[0]);
+      }
+      for (auto p : slots)
+         free(p);
+      return sum;
+   }
+
+   // vectors built by push_back: grow by doubling through realloc, then drop (one op per vector)
+   uint64_t growth(uint64_t ops) {
+      rng r;
+      uint64_t sum = 0;
+      for (uint64_t i = 0; i < ops; i++) {
+         size_t n = 1 + r() % 512, cap = 0;
+         char* p = nullptr;
+         for (size_t len = 0; len < n; len++) {
+            if (len == cap) {
+               cap = cap ? cap * 2 : 8;
+               p = static_cast<char*>(realloc(p, cap));
+            }
+            p[len] = char(len);
+         }
+         sum += uint8_t(p[n - 1]);
+         free(p);
+      }
+      return sum;
+   }
+
+   // row cache teardown: allocate many item sized objects, then free them all
+   uint64_t teardown(uint64_t rounds, size_t items) {
+      std::vector<void*> objs(items);
+      uint64_t sum = 0;
+      for (uint64_t i = 0; i < rounds; i++) {
+         for (auto& o : objs)
+            o = malloc(96);
+         for (auto o : objs)
+            free(o);
+         sum += items;
+      }
+      return sum;
+   }
+
+   // fragmentation: free every other block, then allocate larger ones
+   uint64_t fragment(uint64_t rounds, size_t blocks) {
+      std::vector<void*> small(blocks), large(blocks / 2);
+      uint64_t sum = 0;
+      for (uint64_t i = 0; i < rounds; i++) {
+         for (auto& p : small)
+            p = malloc(40);
+         for (size_t j = 0; j < blocks; j += 2)
+            free(small[j]);
+         for (auto& p : large)
+            p = malloc(120);
+         for (size_t j = 1; j < blocks; j += 2)
+            free(small[j]);
+         for (auto p : large)
+            free(p);
+         sum += blocks;
+      }
+      return sum;
+   }
+}
+
+int main() {
+   run("churn", 2000000, [] { return churn(2000000, 1000); });
+   run("growth", 200000, [] { return growth(200000); });
+   run("teardown", 200 * 5000, [] { return teardown(200, 5000); });
+   run("fragment", 100 * 4000, [] { return fragment(100, 4000); });
+}
@@ -0,0 +1,17 @@
+#!/bin/bash
+# Build bench/memory_bench.cpp against eosiolib/memory.cpp, with and without its SIMD kernels, and run it.
+# -fno-builtin keeps the compiler from inlining the calls under test.
+set -e
+cd "$(dirname "$0")/.."
+CXX=${CXX:-c++}
+FLAGS="-std=c++17 -O2 -Wall -Wextra -fno-builtin"
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+$CXX $FLAGS -o "$OUT/simd" bench/memory_bench.cpp eosiolib/memory.cpp
+$CXX $FLAGS -DEOSIO_CMEM_NO_SIMD -o "$OUT/words" bench/memory_bench.cpp eosiolib/memory.cpp
+
+echo "eosio_cmem, 64-bit words (EOSIO_CMEM_NO_SIMD)"
+"$OUT/words"
+echo "eosio_cmem, SIMD kernels"
+"$OUT/simd"
@@ -0,0 +1,112 @@
+/**
+ * Memory primitives of eosiolib/memory.cpp against the byte loops they
+ * replaced, for the buffer sizes of serialized rows.
+ *
+ * Linked against eosiolib/memory.cpp, which replaces memcpy, memset,
+ * memmove and memcmp for the whole process. Run through bench/memory.sh,
+ * which builds it without compiler builtins so that every call reaches
+ * the implementation under test.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// the reference loops stay scalar, as they would be in a wasm build without simd128
+#if defined(__clang__)
+#define BYTE_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#define SCALAR __attribute__((noinline))
+#else
+#define BYTE_LOOP
+#define SCALAR __attribute__((noinline, optimize("no-tree-vectorize", "no-tree-loop-distribute-patterns")))
+#endif
+
+namespace {
+   // the previous implementation
+   namespace bytes {
+      SCALAR void* memset( void* ptr, int c, size_t n ) {
+         uint8_t* p = (uint8_t*)ptr;
+         BYTE_LOOP
+         for ( size_t i=0; i < n; i++ )
+            p[i] = (uint8_t)c;
+         return ptr;
+      }
+      SCALAR void* memcpy( void* ptr1, const void* ptr2, size_t n ) {
+         uint8_t* p1 = (uint8_t*)ptr1;
+         const uint8_t* p2 = (const uint8_t*)ptr2;
+         BYTE_LOOP
+         for ( size_t i=0; i < n; i++ )
+            p1[i] = p2[i];
+         return ptr1;
+      }
+      SCALAR void* memmove( void* ptr1, const void* ptr2, size_t n ) {
+         uint8_t* p3 = new uint8_t[n];
+         bytes::memcpy( p3, ptr2, n );
+         bytes::memcpy( ptr1, p3, n );
+         delete[] p3;
+         return ptr1;
+      }
+      SCALAR int memcmp( const void* ptr1, const void* ptr2, size_t n ) {
+         const uint8_t* p1 = (const uint8_t*)ptr1;
+         const uint8_t* p2 = (const uint8_t*)ptr2;
+         BYTE_LOOP
+         for ( size_t i=0; i < n; i++ ) {
+            if ( p1[i] < p2[i] )
+               return -1;
+            else if ( p1[i] > p2[i] )
+               return 1;
+         }
+         return 0;
+      }
+   }
+
+   constexpr size_t sizes[] = { 32, 64, 128, 256, 512, 1024, 4096 };
+   constexpr size_t max_size = 4096;
+
+   alignas(16) uint8_t src[max_size + 16];
+   alignas(16) uint8_t dst[max_size + 16];
+   volatile int sink;
+
+   template <typename F>
+   double ns_per_call( size_t size, F&& f ) {
+      // roughly the same number of bytes touched for every size
+      const size_t iterations = (size_t(64) << 20) / size;
+      const auto start = std::chrono::steady_clock::now();
+      for ( size_t i = 0; i < iterations; ++i )
+         f();
+      const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count() / iterations;
+   }
+
+   template <typename Bytes, typename Cmem>
+   void run( const char* name, Bytes&& byte_loop, Cmem&& cmem ) {
+      printf( "%-8s %6s %10s %10s %8s\n", name, "bytes", "byte loop", "cmem", "speedup" );
+      for ( size_t size : sizes ) {
+         const double before = ns_per_call( size, [&] { byte_loop( size ); } );
+         const double after = ns_per_call( size, [&] { cmem( size ); } );
+         printf( "%-8s %6zu %8.1fns %8.1fns %7.1fx\n", "", size, before, after, before / after );
+      }
+      printf( "\n" );
+   }
+}
+
+int main() {
+   for ( size_t i = 0; i < sizeof(src); ++i )
+      src[i] = uint8_t( i * 131 );
+
+   // copies start one byte in, as most serialized fields are unaligned
+   run( "memcpy",
+        [&]( size_t n ) { bytes::memcpy( dst + 1, src, n ); },
+        [&]( size_t n ) { memcpy( dst + 1, src, n ); } );
+   run( "memset",
+        [&]( size_t n ) { bytes::memset( dst, int(n), n ); },
+        [&]( size_t n ) { memset( dst, int(n), n ); } );
+   run( "memmove",
+        [&]( size_t n ) { bytes::memmove( dst + 8, dst, n ); },
+        [&]( size_t n ) { memmove( dst + 8, dst, n ); } );
+
+   memcpy( dst, src, sizeof(src) );
+   run( "memcmp",
+        [&]( size_t n ) { sink = bytes::memcmp( dst, src, n ); },
+        [&]( size_t n ) { sink = memcmp( dst, src, n ); } );
+}
@@ -1,10 +1,16 @@
 #!/bin/bash
 # "pandaheroast" contract name macro: MY_CT_AST
+# LAYER_KEYS=1 keys control tokens by master and layer index (new deployments only)
 trap 'exit' INT 
 CONTRACT='cryptoart'
+FLAGS=''
+if [ -n "$LAYER_KEYS" ]; then
+  FLAGS='-D CRYPTOART_LAYER_KEYS'
+fi
 eosio-cpp \
   -abigen \
   -D MY_CT_AST=pandaheroast \
+  $FLAGS \
   -I include \
   -R src \
   -contract $CONTRACT \
@@ -19,6 +19,7 @@
 #include <limits>
 #include <algorithm>
 #include <memory>
+#include <optional>
 
 namespace eosio {
   namespace internal_use_do_not_use {
@@ -332,12 +333,20 @@ namespace _multi_index_detail {
 
 }
 
+/**
+ *  Slot of an index stored in the slot matching its position among the indices of its table
+ *
+ *  @ingroup multiindex
+ */
+constexpr uint64_t positional_index_slot = 16;
+
 /**
  *  The indexed_by struct is used to instantiate the indices for the Multi-Index table. In EOSIO, up to 16 secondary indices can be specified.
  *
  *  @ingroup multiindex
  *  @tparam IndexName - is the name of the index. The name must be provided as an EOSIO base32 encoded 64-bit integer and must conform to the EOSIO naming requirements of a maximum of 13 characters, the first twelve from the lowercase characters a-z, digits 1-5, and ".", and if there is a 13th character, it is restricted to lowercase characters a-p and ".".
  *  @tparam Extractor - is a function call operator that takes a const reference to the table object type and returns either a secondary key type or a reference to a secondary key type. It is recommended to use the `eosio::const_mem_fun` template, which is a type alias to the `boost::multi_index::const_mem_fun`. See the documentation for the Boost `const_mem_fun` key extractor for more details.
+ *  @tparam Slot - is the slot, from 0 to 15, of the chain table holding the index entries. By default it is the position of the index in the table declaration. Pinning it keeps existing entries reachable when an earlier index is removed, see `multi_index::drop_index`.
  *
  *  Example:
        *
@@ -364,9 +373,11 @@ namespace _multi_index_detail {
  *  EOSIO_DISPATCH( mycontract, (myaction) )
  *  @endcode
  */
-template<name::raw IndexName, typename Extractor>
+template<name::raw IndexName, typename Extractor, uint64_t Slot = positional_index_slot>
 struct indexed_by {
+   static_assert( Slot < 16 || Slot == positional_index_slot, "index slot must be less than 16" );
    enum constants { index_name   = static_cast<uint64_t>(IndexName) };
+   static constexpr uint64_t index_slot = Slot;
    typedef Extractor secondary_extractor_type;
 };
 
@@ -464,6 +475,7 @@ class multi_index
          const multi_index* __idx;
          int32_t            __primary_itr;
          int32_t            __iters[sizeof...(Indices)+(sizeof...(Indices)==0)];
+         uint64_t           __payer = 0; ///< payer of the stored row if written by this instance, 0 if unknown
       };
 
       struct item_ptr
@@ -476,9 +488,127 @@ class multi_index
          int32_t               _primary_itr;
       };
 
-      mutable std::vector<item_ptr> _items_vector;
+      // Objects loaded or created through this multi_index, looked up by primary key or primary iterator in O(1).
+      // Objects live in a dense vector; primary keys and primary iterators are each indexed by an open addressing
+      // table with linear probing and backward shift deletion. Iterators are handed out by the chain for the whole
+      // action, so they are hashed like keys rather than used as offsets into a table sized by the largest one.
+      class item_cache {
+         public:
+            const item* find_by_primary_key( uint64_t pk )const {
+               auto slot = find_slot( _pk_slots, by_primary_key, pk );
+               return slot == npos ? nullptr : _items[_pk_slots[slot] - 1]._item.get();
+            }
+
+            const item* find_by_primary_iterator( int32_t itr )const {
+               if( itr < 0 ) return nullptr;
+               auto slot = find_slot( _itr_slots, by_primary_iterator, uint32_t(itr) );
+               return slot == npos ? nullptr : _items[_itr_slots[slot] - 1]._item.get();
+            }
+
+            void insert( std::unique_ptr<item>&& i, uint64_t pk, int32_t pitr ) {
+               _items.emplace_back( std::move(i), pk, pitr );
+               grow_or_place( _pk_slots, by_primary_key, _items.size() );
+               if( pitr >= 0 )
+                  grow_or_place( _itr_slots, by_primary_iterator, ++_itr_count );
+            }
+
+            // Returns false if no object with this primary key is cached.
+            bool erase( uint64_t pk ) {
+               auto slot = find_slot( _pk_slots, by_primary_key, pk );
+               if( slot == npos ) return false;
+
+               size_t idx = _pk_slots[slot] - 1;
+               remove_slot( _pk_slots, by_primary_key, slot );
+               if( _items[idx]._primary_itr >= 0 ) {
+                  remove_slot( _itr_slots, by_primary_iterator, itr_slot( idx ) );
+                  --_itr_count;
+               }
+
+               size_t last = _items.size() - 1;
+               if( idx != last ) {
+                  size_t last_itr_slot = _items[last]._primary_itr >= 0 ? itr_slot( last ) : npos;
+                  _items[idx] = std::move( _items[last] );
+                  _pk_slots[find_slot( _pk_slots, by_primary_key, _items[idx]._primary_key )] = idx + 1;
+                  if( last_itr_slot != npos )
+                     _itr_slots[last_itr_slot] = idx + 1;
+               }
+               _items.pop_back();
+               return true;
+            }
+
+         private:
+            static constexpr size_t npos = size_t(-1);
+
+            enum key_kind { by_primary_key, by_primary_iterator };
+
+            uint64_t key_of( size_t idx, key_kind kind )const {
+               return kind == by_primary_key ? _items[idx]._primary_key : uint32_t(_items[idx]._primary_itr);
+            }
+
+            static size_t home( const std::vector<uint32_t>& slots, uint64_t key ) {
+               return size_t( (key * 0x9E3779B97F4A7C15ULL) >> 32 ) & (slots.size() - 1);
+            }
+
+            size_t find_slot( const std::vector<uint32_t>& slots, key_kind kind, uint64_t key )const {
+               if( slots.empty() ) return npos;
+               for( size_t i = home( slots, key ); slots[i] != 0; i = (i + 1) & (slots.size() - 1) ) {
+                  if( key_of( slots[i] - 1, kind ) == key )
+                     return i;
+               }
+               return npos;
+            }
+
+            // slot of the primary iterator of _items[idx], which must be indexed
+            size_t itr_slot( size_t idx )const {
+               return find_slot( _itr_slots, by_primary_iterator, key_of( idx, by_primary_iterator ) );
+            }
+
+            void place( std::vector<uint32_t>& slots, key_kind kind, size_t idx ) {
+               size_t i = home( slots, key_of( idx, kind ) );
+               while( slots[i] != 0 )
+                  i = (i + 1) & (slots.size() - 1);
+               slots[i] = idx + 1;
+            }
+
+            // Indexes the last object in `slots`, which then holds `count` entries, keeping the load at most 1/2.
+            void grow_or_place( std::vector<uint32_t>& slots, key_kind kind, size_t count ) {
+               if( count * 2 <= slots.size() ) {
+                  place( slots, kind, _items.size() - 1 );
+                  return;
+               }
+               slots.assign( slots.size() ? slots.size() * 2 : 16, 0 );
+               for( size_t idx = 0; idx < _items.size(); ++idx ) {
+                  if( kind == by_primary_key || _items[idx]._primary_itr >= 0 )
+                     place( slots, kind, idx );
+               }
+            }
+
+            // Backward shift deletion keeps every probe chain free of holes.
+            void remove_slot( std::vector<uint32_t>& slots, key_kind kind, size_t hole ) {
+               const size_t mask = slots.size() - 1;
+               slots[hole] = 0;
+               for( size_t i = (hole + 1) & mask; slots[i] != 0; i = (i + 1) & mask ) {
+                  size_t h = home( slots, key_of( slots[i] - 1, kind ) );
+                  // move the entry into the hole unless its home lies cyclically in (hole, i]
+                  bool stays = hole < i ? (h > hole && h <= i) : (h > hole || h <= i);
+                  if( !stays ) {
+                     slots[hole] = slots[i];
+                     slots[i] = 0;
+                     hole = i;
+                  }
+               }
+            }
+
+            std::vector<item_ptr> _items;
+            // index + 1 into _items, 0 for an empty slot
+            std::vector<uint32_t> _pk_slots;
+            std::vector<uint32_t> _itr_slots;
+            size_t                _itr_count = 0; ///< objects with a primary iterator, all of them in _itr_slots
+      };
+
+      mutable item_cache _items_cache;
 
-      template<name::raw IndexName, typename Extractor, uint64_t Number, bool IsConst>
+      template<name::raw IndexName, typename Extractor, uint64_t Number, bool IsConst, uint64_t Slot>
       struct index {
          public:
             typedef Extractor  secondary_extractor_type;
@@ -488,14 +618,15 @@ class multi_index
                return n.value != 0 && n != eosio::name("primary"); // Primary is a reserve index name.
             }
 
-            static_assert( validate_index_name( name(IndexName) ), "invalid index name used in multi_index" );
+            static_assert( validate_index_name( eosio::name(IndexName) ), "invalid index name used in multi_index" );
 
             enum constants {
                table_name   = static_cast<uint64_t>(TableName),
                index_name   = static_cast<uint64_t>(IndexName),
                index_number = Number,
+               index_slot   = Slot == positional_index_slot ? Number : Slot,
                index_table_name = (static_cast<uint64_t>(TableName) & 0xFFFFFFFFFFFFFFF0ULL)
-                                    | (Number & 0x000000000000000FULL) // Assuming no more than 16 secondary indices are allowed
+                                    | (index_slot & 0x000000000000000FULL) // Assuming no more than 16 secondary indices are allowed
             };
 
             constexpr static uint64_t name()   { return index_table_name; }
@@ -681,6 +812,30 @@ class multi_index
                return {this, &mi};
             }
 
+            // Gets the primary keys of all objects with a secondary key in [lower, upper], in index order.
+            // Only secondary iterators are walked; no object is loaded from the table or deserialized.
+            std::vector<uint64_t> primary_keys( const secondary_key_type& lower, const secondary_key_type& upper )const {
+               using namespace _multi_index_detail;
+
+               std::vector<uint64_t> keys;
+               if( upper < lower ) return keys;
+
+               uint64_t primary = 0;
+               secondary_key_type lower_copy(lower);
+               auto itr = secondary_index_db_functions<secondary_key_type>::db_idx_lowerbound( get_code().value, get_scope(), name(), lower_copy, primary );
+
+               // the chain hands out one iterator per index entry, so the upper bound iterator is a valid sentinel
+               uint64_t end_primary = 0;
+               secondary_key_type upper_copy(upper);
+               auto end_itr = secondary_index_db_functions<secondary_key_type>::db_idx_upperbound( get_code().value, get_scope(), name(), upper_copy, end_primary );
+
+               while( itr >= 0 && itr != end_itr ) {
+                  keys.push_back( primary );
+                  itr = secondary_index_db_functions<secondary_key_type>::db_idx_next( itr, &primary );
+               }
+               return keys;
+            }
+
             const_iterator iterator_to( const T& obj ) {
                using namespace _multi_index_detail;
 
@@ -746,10 +901,10 @@ class multi_index
              typedef typename std::decay<decltype(hana::at_c<1>(idx))>::type idx_type;
              return hana::make_tuple( hana::type_c<index<eosio::name::raw(static_cast<uint64_t>(idx_type::index_name)),
                                                          typename idx_type::secondary_extractor_type,
-                                                         num_type::e::value, false> >,
+                                                         num_type::e::value, false, idx_type::index_slot> >,
                                       hana::type_c<index<eosio::name::raw(static_cast<uint64_t>(idx_type::index_name)),
                                                          typename idx_type::secondary_extractor_type,
-                                                         num_type::e::value, true> > );
+                                                         num_type::e::value, true, idx_type::index_slot> > );
 
          });
       }
@@ -761,11 +916,8 @@ class multi_index
       const item& load_object_by_primary_iterator( int32_t itr )const {
          using namespace _multi_index_detail;
 
-         auto itr2 = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr) {
-            return ptr._primary_itr == itr;
-         });
-         if( itr2 != _items_vector.rend() )
-            return *itr2->_item;
+         if( auto cached = _items_cache.find_by_primary_iterator( itr ) )
+            return *cached;
 
          auto size = internal_use_do_not_use::db_get_i64( itr, nullptr, 0 );
          eosio::check( size >= 0, "error reading iterator" );
@@ -775,11 +927,9 @@ class multi_index
 
          internal_use_do_not_use::db_get_i64( itr, buffer, uint32_t(size) );
 
-         datastream<const char*> ds( (char*)buffer, uint32_t(size) );
-
          auto itm = std::make_unique<item>( this, [&]( auto& i ) {
             T& val = static_cast<T&>(i);
-            ds >> val;
+            unpack( (const char*)buffer, size_t(size), val );
 
             i.__primary_itr = itr;
             hana::for_each( _indices, [&]( auto& idx ) {
@@ -793,7 +943,7 @@ class multi_index
          auto pk   = itm->primary_key();
          auto pitr = itm->__primary_itr;
 
-         _items_vector.emplace_back( std::move(itm), pk, pitr );
+         _items_cache.insert( std::move(itm), pk, pitr );
 
          if ( max_stack_buffer_size < size_t(size) ) {
             free(buffer);
@@ -802,6 +952,83 @@ class multi_index
          return *ptr;
       } /// load_object_by_primary_iterator
 
+      template<typename Lambda>
+      bool update( const T& obj, name payer, Lambda&& updater, bool skip_unchanged ) {
+         using namespace _multi_index_detail;
+
+         const auto& objitem = static_cast<const item&>(obj);
+         eosio::check( objitem.__idx == this, "object passed to modify is not in multi_index" );
+         auto& mutableitem = const_cast<item&>(objitem);
+         eosio::check( _code == current_receiver(), "cannot modify objects in table of another contract" ); // Quick fix for mutating db using multi_index that shouldn't allow mutation. Real fix can come in RC2.
+
+         auto secondary_keys = hana::transform( _indices, [&]( auto&& idx ) {
+            typedef typename decltype(+hana::at_c<0>(idx))::type index_type;
+
+            return index_type::extract_secondary_key( obj );
+         });
+
+         auto pk = obj.primary_key();
+
+         skip_unchanged = skip_unchanged && (payer == same_payer || payer.value == objitem.__payer);
+         size_t old_size = 0;
+         void* old_buffer = nullptr;
+         if( skip_unchanged ) {
+            old_size = pack_size( obj );
+            old_buffer = max_stack_buffer_size < old_size ? malloc(old_size) : alloca(old_size);
+            pack( (char*)old_buffer, old_size, obj );
+         }
+
+         auto& mutableobj = const_cast<T&>(obj); // Do not forget the auto& otherwise it would make a copy and thus not update at all.
+         updater( mutableobj );
+
+         eosio::check( pk == obj.primary_key(), "updater cannot change primary key when modifying an object" );
+
+         size_t size = pack_size( obj );
+         //using malloc/free here potentially is not exception-safe, although WASM doesn't support exceptions
+         void* buffer = max_stack_buffer_size < size ? malloc(size) : alloca(size);
+
+         pack( (char*)buffer, size, obj );
+
+         // identical bytes also mean identical secondary keys, so there is nothing left to update
+         const bool unchanged = skip_unchanged && size == old_size && memcmp( buffer, old_buffer, size ) == 0;
+         if( !unchanged ) {
+            internal_use_do_not_use::db_update_i64( objitem.__primary_itr, payer.value, buffer, size );
+            if( payer != same_payer )
+               mutableitem.__payer = payer.value;
+         }
+
+         if ( max_stack_buffer_size < size ) {
+            free( buffer );
+         }
+         if ( max_stack_buffer_size < old_size ) {
+            free( old_buffer );
+         }
+
+         if( unchanged )
+            return false;
+
+         if( pk >= _next_primary_key )
+            _next_primary_key = (pk >= no_available_primary_key) ? no_available_primary_key : (pk + 1);
+
+         hana::for_each( _indices, [&]( auto& idx ) {
+            typedef typename decltype(+hana::at_c<0>(idx))::type index_type;
+
+            auto secondary = index_type::extract_secondary_key( obj );
+            if( memcmp( &hana::at_c<index_type::index_number>(secondary_keys), &secondary, sizeof(secondary) ) != 0 ) {
+               auto indexitr = mutableitem.__iters[index_type::number()];
+
+               if( indexitr < 0 ) {
+                  typename index_type::secondary_key_type temp_secondary_key;
+                  indexitr = mutableitem.__iters[index_type::number()]
+                           = secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_find_primary( _code.value, _scope, index_type::name(), pk,  temp_secondary_key );
+               }
+
+               secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_update( indexitr, payer.value, secondary );
+            }
+         });
+         return true;
+      }
+
    public:
       /**
        *  Constructs an instance of a Multi-Index table.
@@ -1057,6 +1284,12 @@ class multi_index
        */
       const_iterator end()const    { return cend(); }
 
+      /**
+       *  Secondary keys of an object, one per secondary index in declaration order.
+       *  @ingroup multiindex
+       */
+      typedef std::tuple<typename std::decay<decltype( typename Indices::secondary_extractor_type()(nullptr) )>::type...> secondary_keys_type;
+
       /**
        *  Returns a reverse iterator pointing to the `object_type` with the highest primary key value in the Multi-Index table.
        *  @ingroup multiindex
@@ -1536,12 +1769,12 @@ class multi_index
             //using malloc/free here potentially is not exception-safe, although WASM doesn't support exceptions
             void* buffer = max_stack_buffer_size < size ? malloc(size) : alloca(size);
 
-            datastream<char*> ds( (char*)buffer, size );
-            ds << obj;
+            pack( (char*)buffer, size, obj );
 
             auto pk = obj.primary_key();
 
             i.__primary_itr = internal_use_do_not_use::db_store_i64( _scope, static_cast<uint64_t>(TableName), payer.value, pk, buffer, size );
+            i.__payer = payer.value;
 
             if ( max_stack_buffer_size < size ) {
                free(buffer);
@@ -1561,7 +1794,7 @@ class multi_index
          auto pk   = itm->primary_key();
          auto pitr = itm->__primary_itr;
 
-         _items_vector.emplace_back( std::move(itm), pk, pitr );
+         _items_cache.insert( std::move(itm), pk, pitr );
 
          return {this, ptr};
       }
@@ -1656,58 +1889,65 @@ class multi_index
        */
       template<typename Lambda>
       void modify( const T& obj, name payer, Lambda&& updater ) {
-         using namespace _multi_index_detail;
-
-         const auto& objitem = static_cast<const item&>(obj);
-         eosio::check( objitem.__idx == this, "object passed to modify is not in multi_index" );
-         auto& mutableitem = const_cast<item&>(objitem);
-         eosio::check( _code == current_receiver(), "cannot modify objects in table of another contract" ); // Quick fix for mutating db using multi_index that shouldn't allow mutation. Real fix can come in RC2.
-
-         auto secondary_keys = hana::transform( _indices, [&]( auto&& idx ) {
-            typedef typename decltype(+hana::at_c<0>(idx))::type index_type;
-
-            return index_type::extract_secondary_key( obj );
-         });
-
-         auto pk = obj.primary_key();
-
-         auto& mutableobj = const_cast<T&>(obj); // Do not forget the auto& otherwise it would make a copy and thus not update at all.
-         updater( mutableobj );
-
-         eosio::check( pk == obj.primary_key(), "updater cannot change primary key when modifying an object" );
-
-         size_t size = pack_size( obj );
-         //using malloc/free here potentially is not exception-safe, although WASM doesn't support exceptions
-         void* buffer = max_stack_buffer_size < size ? malloc(size) : alloca(size);
-
-         datastream<char*> ds( (char*)buffer, size );
-         ds << obj;
-
-         internal_use_do_not_use::db_update_i64( objitem.__primary_itr, payer.value, buffer, size );
-
-         if ( max_stack_buffer_size < size ) {
-            free( buffer );
-         }
-
-         if( pk >= _next_primary_key )
-            _next_primary_key = (pk >= no_available_primary_key) ? no_available_primary_key : (pk + 1);
-
-         hana::for_each( _indices, [&]( auto& idx ) {
-            typedef typename decltype(+hana::at_c<0>(idx))::type index_type;
+         update( obj, payer, std::forward<Lambda&&>(updater), false );
+      }
 
-            auto secondary = index_type::extract_secondary_key( obj );
-            if( memcmp( &hana::at_c<index_type::index_number>(secondary_keys), &secondary, sizeof(secondary) ) != 0 ) {
-               auto indexitr = mutableitem.__iters[index_type::number()];
+      /**
+       *  Modifies an existing object in a table, skipping the database write when nothing changed.
+       *  @ingroup multiindex
+       *
+       *  @param itr - an iterator pointing to the object to be updated
+       *  @param payer - account name of the payer for the Storage usage of the updated row
+       *  @param updater - lambda function that updates the target object
+       *  @return true if the row was written, false if its serialized bytes and payer were unchanged
+       *
+       *  @pre itr points to an existing element
+       *  @pre payer is a valid account that is authorized to execute the action and be billed for storage usage.
+       *
+       *  @post Same as modify() when the row changed.
+       */
+      template<typename Lambda>
+      bool modify_if_changed( const_iterator itr, name payer, Lambda&& updater ) {
+         eosio::check( itr != end(), "cannot pass end iterator to modify" );
 
-               if( indexitr < 0 ) {
-                  typename index_type::secondary_key_type temp_secondary_key;
-                  indexitr = mutableitem.__iters[index_type::number()]
-                           = secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_find_primary( _code.value, _scope, index_type::name(), pk,  temp_secondary_key );
-               }
+         return modify_if_changed( *itr, payer, std::forward<Lambda&&>(updater) );
+      }
 
-               secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_update( indexitr, payer.value, secondary );
-            }
-         });
+      /**
+       *  Modifies an existing object in a table, skipping the database write when nothing changed.
+       *  @ingroup multiindex
+       *
+       *  @details The object is serialized before and after running the updater; when both encodings
+       *  are identical and the payer is unchanged, the row and its secondary indices are left as they are.
+       *  The payer counts as unchanged when it is same_payer, or the payer this table last wrote the row
+       *  with. Rows read but never written by this instance have an unknown payer, so an explicit payer
+       *  always writes them.
+       *
+       *  Costs one extra serialization when the row does change, so use modify() for updates that
+       *  rarely leave the row as it was.
+       *
+       *  @param obj - a reference to the object to be updated
+       *  @param payer - account name of the payer for the Storage usage of the updated row
+       *  @param updater - lambda function that updates the target object
+       *  @return true if the row was written, false if its serialized bytes and payer were unchanged
+       *
+       *  @pre obj is an existing object in the table
+       *  @pre payer is a valid account that is authorized to execute the action and be billed for storage usage.
+       *
+       *  @post Same as modify() when the row changed.
+       *
+       *  Example:
+       *
+       *  @code
+       *  // bots repeating the same update only pay for the comparison
+       *  addresses.modify_if_changed( *itr, same_payer, [&]( auto& address ) {
+       *    address.city = city;
+       *  });
+       *  @endcode
+       */
+      template<typename Lambda>
+      bool modify_if_changed( const T& obj, name payer, Lambda&& updater ) {
+         return update( obj, payer, std::forward<Lambda&&>(updater), true );
       }
 
       /**
@@ -1765,11 +2005,8 @@ class multi_index
        *  @endcode
        */
       const_iterator find( uint64_t primary )const {
-         auto itr2 = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr) {
-            return ptr._item->primary_key() == primary;
-         });
-         if( itr2 != _items_vector.rend() )
-            return iterator_to(*(itr2->_item));
+         if( auto cached = _items_cache.find_by_primary_key( primary ) )
+            return iterator_to(*cached);
 
          auto itr = internal_use_do_not_use::db_find_i64( _code.value, _scope, static_cast<uint64_t>(TableName), primary );
          if( itr < 0 ) return end();
@@ -1788,11 +2025,8 @@ class multi_index
        */
 
       const_iterator require_find( uint64_t primary, const char* error_msg = "unable to find key" )const {
-         auto itr2 = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr) {
-               return ptr._item->primary_key() == primary;
-            });
-         if( itr2 != _items_vector.rend() )
-            return iterator_to(*(itr2->_item));
+         if( auto cached = _items_cache.find_by_primary_key( primary ) )
+            return iterator_to(*cached);
 
          auto itr = internal_use_do_not_use::db_find_i64( _code.value, _scope, static_cast<uint64_t>(TableName), primary );
          eosio::check( itr >= 0,  error_msg );
@@ -1801,6 +2035,53 @@ class multi_index
          return iterator_to(static_cast<const T&>(i));
       }
 
+      /**
+       *  Read some fields of an existing object without loading the whole object.
+       *  @ingroup multiindex
+       *
+       *  Fields are numbered in declaration order. Fields before the last requested one are skipped in the row
+       *  buffer without being decoded, so strings and vectors among them are never allocated. The object is not
+       *  added to the cache. If it is already cached, the fields are copied from the cached object.
+       *
+       *  @tparam I - Indices of the requested fields, in increasing order
+       *  @param primary - Primary key value of the object
+       *  @return The requested fields in the order of `I`, or no value if an object with primary key `primary` is not found.
+       *
+       *  Example:
+       *
+       *  @code
+       *  // Read the city of an address, its fifth field
+       *  auto city = addresses.get_fields<4>("dan"_n.value);
+       *  eosio::check(city && std::get<0>(*city) == "Hong Kong", "Dan moved");
+       *  @endcode
+       */
+      template<std::size_t... I>
+      std::optional<std::tuple<boost::pfr::tuple_element_t<I, T>...>> get_fields( uint64_t primary )const {
+         if( auto cached = _items_cache.find_by_primary_key( primary ) ) {
+            const T& obj = static_cast<const T&>(*cached);
+            return std::make_tuple( boost::pfr::get<I>( obj )... );
+         }
+
+         auto itr = internal_use_do_not_use::db_find_i64( _code.value, _scope, static_cast<uint64_t>(TableName), primary );
+         if( itr < 0 ) return {};
+
+         auto size = internal_use_do_not_use::db_get_i64( itr, nullptr, 0 );
+         eosio::check( size >= 0, "error reading iterator" );
+
+         //using malloc/free here potentially is not exception-safe, although WASM doesn't support exceptions
+         void* buffer = max_stack_buffer_size < size_t(size) ? malloc(size_t(size)) : alloca(size_t(size));
+
+         internal_use_do_not_use::db_get_i64( itr, buffer, uint32_t(size) );
+
+         auto fields = unpack_fields<T, I...>( (const char*)buffer, size_t(size) );
+
+         if ( max_stack_buffer_size < size_t(size) ) {
+            free(buffer);
+         }
+
+         return fields;
+      }
+
       /**
        *  Remove an existing object from a table using its primary key.
        *  @ingroup multiindex
@@ -1888,13 +2169,7 @@ class multi_index
          eosio::check( _code == current_receiver(), "cannot erase objects in table of another contract" ); // Quick fix for mutating db using multi_index that shouldn't allow mutation. Real fix can come in RC2.
 
          auto pk = objitem.primary_key();
-         auto itr2 = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr) {
-            return ptr._item->primary_key() == pk;
-         });
-
-         eosio::check( itr2 != _items_vector.rend(), "attempt to remove object that was not in multi_index" );
-
-         _items_vector.erase(--(itr2.base()));
+         eosio::check( _items_cache.find_by_primary_key( pk ) == &objitem, "attempt to remove object that was not in multi_index" );
 
          internal_use_do_not_use::db_remove_i64( objitem.__primary_itr );
 
@@ -1904,11 +2179,180 @@ class multi_index
             auto i = objitem.__iters[index_type::number()];
             if( i < 0 ) {
               typename index_type::secondary_key_type secondary;
-              i = secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_find_primary( _code.value, _scope, index_type::name(), objitem.primary_key(),  secondary );
+              i = secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_find_primary( _code.value, _scope, index_type::name(), pk,  secondary );
             }
             if( i >= 0 )
                secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_remove( i );
          });
+
+         // destroys the object, so it must come last
+         _items_cache.erase( pk );
+      }
+
+      /**
+       *  Remove objects in primary key order, starting from the first object with a primary key not less than `lower`,
+       *  without loading them. Rows are removed through primary iterators and their secondary index entries are looked
+       *  up by primary key, so the objects are never deserialized.
+       *  @ingroup multiindex
+       *
+       *  @param lower - Lowest primary key to remove
+       *  @param max_rows - Maximum number of objects to remove
+       *  @param on_erase - Called as `on_erase( primary_key, secondary_keys )` before each object is removed, with the
+       *  keys read back from the secondary indices as a `secondary_keys_type`
+       *
+       *  @pre No reference to a removed object obtained from this multi_index is used afterwards.
+       *  @post The objects are removed from the table and all associated storage is reclaimed.
+       *  @post Secondary indices associated with the table are updated.
+       *
+       *  @return The primary key of the first object left after the removed range, or no value if none is left.
+       *
+       *  Example:
+       *
+       *  @code
+       *  // Remove at most 100 addresses per call, resuming from a stored key
+       *  auto next = addresses.truncate( resume_key, 100 );
+       *  @endcode
+       */
+      template<typename Callback>
+      std::optional<uint64_t> truncate( uint64_t lower, uint64_t max_rows, Callback&& on_erase ) {
+         using namespace _multi_index_detail;
+
+         eosio::check( _code == current_receiver(), "cannot erase objects in table of another contract" ); // Quick fix for mutating db using multi_index that shouldn't allow mutation. Real fix can come in RC2.
+
+         auto itr = internal_use_do_not_use::db_lowerbound_i64( _code.value, _scope, static_cast<uint64_t>(TableName), lower );
+         if( itr < 0 ) return {};
+
+         // the primary key of the first row is read back through its successor
+         uint64_t pk = 0;
+         uint64_t next_pk = 0;
+         auto next_itr = internal_use_do_not_use::db_next_i64( itr, &next_pk );
+         internal_use_do_not_use::db_previous_i64( next_itr, &pk );
+
+         for( uint64_t n = 0; n < max_rows; ++n ) {
+            secondary_keys_type secondary_keys;
+            hana::for_each( _indices, [&]( auto& idx ) {
+               typedef typename decltype(+hana::at_c<0>(idx))::type index_type;
+
+               auto& secondary = std::get<index_type::number()>( secondary_keys );
+               auto i = secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_find_primary( _code.value, _scope, index_type::name(), pk, secondary );
+               if( i >= 0 )
+                  secondary_index_db_functions<typename index_type::secondary_key_type>::db_idx_remove( i );
+            });
+
+            on_erase( pk, static_cast<const secondary_keys_type&>(secondary_keys) );
+
+            _items_cache.erase( pk );
+
+            internal_use_do_not_use::db_remove_i64( itr );
+
+            if( next_itr < 0 ) return {};
+            itr = next_itr;
+            pk  = next_pk;
+            next_itr = internal_use_do_not_use::db_next_i64( itr, &next_pk );
+         }
+
+         return pk;
+      }
+
+      std::optional<uint64_t> truncate( uint64_t lower, uint64_t max_rows ) {
+         return truncate( lower, max_rows, []( uint64_t, const secondary_keys_type& ) {} );
+      }
+
+      /**
+       *  Remove the entries of a secondary index that this table no longer declares, without loading any object.
+       *  @ingroup multiindex
+       *
+       *  Indices declared after the dropped one must pin their slots with `indexed_by` so that they keep reaching
+       *  their existing entries.
+       *
+       *  @tparam SecondaryKey - Key type of the dropped index
+       *  @param slot - Slot of the dropped index, i.e. its position in the table declaration that created it
+       *  @param max_entries - Maximum number of entries to remove
+       *
+       *  @return Whether entries of the dropped index are left.
+       *
+       *  Example:
+       *
+       *  @code
+       *  // "byzip" was the first index of addresses, remove at most 100 of its entries per call
+       *  bool more = addresses.drop_index<uint64_t>( 0, 100 );
+       *  @endcode
+       */
+      template<typename SecondaryKey>
+      bool drop_index( uint64_t slot, uint64_t max_entries ) {
+         using namespace _multi_index_detail;
+
+         eosio::check( _code == current_receiver(), "cannot erase objects in table of another contract" ); // Quick fix for mutating db using multi_index that shouldn't allow mutation. Real fix can come in RC2.
+         eosio::check( slot < 16, "index slot must be less than 16" );
+
+         hana::for_each( _indices, [&]( auto& idx ) {
+            typedef typename decltype(+hana::at_c<0>(idx))::type index_type;
+
+            if constexpr( std::is_same<typename index_type::secondary_key_type, SecondaryKey>::value )
+               eosio::check( index_type::index_slot != slot, "cannot drop an index declared by the table" );
+         });
+
+         using db_functions = secondary_index_db_functions<SecondaryKey>;
+         uint64_t table = (static_cast<uint64_t>(TableName) & 0xFFFFFFFFFFFFFFF0ULL) | slot;
+
+         SecondaryKey secondary = secondary_key_traits<SecondaryKey>::true_lowest();
+         uint64_t primary = 0;
+         auto itr = db_functions::db_idx_lowerbound( _code.value, _scope, table, secondary, primary );
+         for( uint64_t n = 0; n < max_entries && itr >= 0; ++n ) {
+            auto next_itr = db_functions::db_idx_next( itr, &primary );
+            db_functions::db_idx_remove( itr );
+            itr = next_itr;
+         }
+
+         return itr >= 0;
+      }
+
+      /**
+       *  Store the missing entries of a secondary index for objects created before the index was declared.
+       *  @ingroup multiindex
+       *
+       *  Objects are visited in primary key order, starting from the first object with a primary key not less than
+       *  `lower`. Objects whose entry exists are left as they are. Until every object has its entry, modifying an
+       *  object without one fails.
+       *
+       *  @tparam IndexName - Name of the index to fill
+       *  @param lower - Lowest primary key to visit
+       *  @param max_rows - Maximum number of objects to visit
+       *  @param payer - Account name of the payer for the stored entries
+       *
+       *  @return The primary key of the first object left to visit, or no value if none is left.
+       *
+       *  Example:
+       *
+       *  @code
+       *  // "byzip" was added to addresses, fill it for at most 100 addresses per call
+       *  auto next = addresses.backfill_index<"byzip"_n>( resume_key, 100, get_self() );
+       *  @endcode
+       */
+      template<name::raw IndexName>
+      std::optional<uint64_t> backfill_index( uint64_t lower, uint64_t max_rows, name payer ) {
+         using namespace _multi_index_detail;
+
+         eosio::check( _code == current_receiver(), "cannot create objects in table of another contract" ); // Quick fix for mutating db using multi_index that shouldn't allow mutation. Real fix can come in RC2.
+
+         using index_type   = decltype( get_index<IndexName>() );
+         using key_type     = typename index_type::secondary_key_type;
+         using db_functions = secondary_index_db_functions<key_type>;
+
+         auto itr = lower_bound( lower );
+         for( uint64_t n = 0; n < max_rows && itr != end(); ++n, ++itr ) {
+            auto& mutableitem = const_cast<item&>( static_cast<const item&>(*itr) );
+            auto pk = mutableitem.primary_key();
+
+            key_type secondary;
+            auto indexitr = db_functions::db_idx_find_primary( _code.value, _scope, index_type::name(), pk, secondary );
+            if( indexitr < 0 )
+               indexitr = db_functions::db_idx_store( _scope, index_type::name(), payer.value, pk, index_type::extract_secondary_key( *itr ) );
+            mutableitem.__iters[index_type::number()] = indexitr;
+         }
+
+         if( itr == end() ) return {};
+         return itr->primary_key();
       }
 
 };
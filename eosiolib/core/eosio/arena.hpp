@@ -0,0 +1,57 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#pragma once
+
+namespace eosio {
+
+   namespace internal_use_do_not_use {
+      extern "C" {
+         void* eosio_dsm_mark();
+
+         void eosio_dsm_reset( void* mark );
+      }
+   }
+
+   /**
+    *  @defgroup arena Arena
+    *  @ingroup core
+    *  @brief Scoped scratch memory for contracts linked with the bump allocator
+    */
+
+   /**
+    *  Releases every allocation made during its lifetime when it goes out of
+    *  scope, by rewinding the bump allocator (`eosio_dsm`) to the position
+    *  it had on construction. Objects allocated inside the scope must be
+    *  destroyed before the arena is.
+    *
+    *  Only available when linking with `eosio_dsm`.
+    *
+    *  @ingroup arena
+    *
+    *  Example:
+    *  @code
+    *  {
+    *     eosio::scoped_arena scratch;
+    *     std::vector<char> buffer(4096);
+    *     // ...
+    *  } // buffer and anything else allocated above are released here
+    *  @endcode
+    */
+   class scoped_arena {
+   public:
+      scoped_arena() : _mark( internal_use_do_not_use::eosio_dsm_mark() ) {}
+
+      ~scoped_arena() { reset(); }
+
+      scoped_arena( const scoped_arena& ) = delete;
+      scoped_arena& operator=( const scoped_arena& ) = delete;
+
+      /// Release everything allocated since construction and keep the arena open
+      void reset() { internal_use_do_not_use::eosio_dsm_reset( _mark ); }
+
+   private:
+      void* _mark;
+   };
+}
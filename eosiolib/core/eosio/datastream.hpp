@@ -468,6 +468,184 @@ inline datastream<Stream>& operator>>(datastream<Stream>& ds, bool& d) {
   return ds;
 }
 
+namespace _datastream_detail {
+   /**
+    * Check if type T is a pointer
+    *
+    * @brief Check if type T is a pointer
+    * @tparam T - The type to be checked
+    * @return true if T is a pointer
+    * @return false otherwise
+    */
+   template<typename T>
+   constexpr bool is_pointer() {
+      return std::is_pointer<T>::value ||
+             std::is_null_pointer<T>::value ||
+             std::is_member_pointer<T>::value;
+   }
+
+   /**
+    * Check if type T is a primitive type
+    *
+    * @brief Check if type T is a primitive type
+    * @tparam T - The type to be checked
+    * @return true if T is a primitive type
+    * @return false otherwise
+    */
+   template<typename T>
+   constexpr bool is_primitive() {
+      return std::is_arithmetic<T>::value ||
+             std::is_enum<T>::value;
+   }
+
+   /**
+    * Check if a sequence of T is serialized as its in-memory bytes, so that
+    * a whole array of T can be copied with a single bounds check
+    *
+    * @brief Check if a sequence of T can be copied in bulk
+    * @tparam T - The type to be checked
+    * @return true if T is a primitive type other than bool
+    * @return false otherwise
+    */
+   template<typename T>
+   constexpr bool is_bulk_copyable() {
+      return is_primitive<T>() && !std::is_same<T, bool>::value;
+   }
+
+   template<typename T>
+   struct fixed_pack_size;
+
+   template<typename T, typename = void>
+   struct has_declared_pack_size : std::false_type {};
+
+   template<typename T>
+   struct has_declared_pack_size<T, std::void_t<decltype(T::eosio_fixed_pack_size())>> : std::true_type {};
+
+   template<typename T>
+   struct is_std_array : std::false_type {};
+
+   template<typename T, std::size_t N>
+   struct is_std_array<std::array<T,N>> : std::true_type {};
+
+   template<typename T>
+   struct is_std_tuple : std::false_type {};
+
+   template<typename... Ts>
+   struct is_std_tuple<std::tuple<Ts...>> : std::true_type {};
+
+   template<typename T1, typename T2>
+   struct is_std_tuple<std::pair<T1,T2>> : std::true_type {};
+
+   /**
+    * Packed size shared by a sequence of values of types Ts, if each of them has a fixed packed size
+    *
+    * @brief Packed size of a sequence of fixed size types
+    * @tparam Ts - The types of the sequence
+    * @return the sum of their packed sizes, or 0 if any of them is variable or the sequence is empty
+    */
+   template<typename... Ts>
+   constexpr size_t fixed_pack_size_of() {
+      if constexpr( sizeof...(Ts) == 0 )
+         return 0;
+      else
+         return ((fixed_pack_size<Ts>::value != 0) && ...) ? (fixed_pack_size<Ts>::value + ...) : 0;
+   }
+
+   template<typename T, std::size_t... I>
+   constexpr size_t fixed_pack_size_of_tuple( std::index_sequence<I...> ) {
+      return fixed_pack_size_of<std::tuple_element_t<I, T>...>();
+   }
+
+   // member types as listed by EOSLIB_SERIALIZE, after a leading void so that
+   // an empty member list still forms a valid argument list
+   template<typename Void, typename... Ts>
+   constexpr size_t fixed_pack_size_of_members() {
+      return fixed_pack_size_of<Ts...>();
+   }
+
+   template<typename T>
+   constexpr size_t deduce_fixed_pack_size() {
+      if constexpr( is_primitive<T>() )
+         return sizeof(T);
+      else if constexpr( has_declared_pack_size<T>::value )
+         return T::eosio_fixed_pack_size();
+      else if constexpr( is_std_array<T>::value )
+         return std::tuple_size<T>::value * fixed_pack_size<typename T::value_type>::value;
+      else if constexpr( is_std_tuple<T>::value )
+         return fixed_pack_size_of_tuple<T>( std::make_index_sequence<std::tuple_size<T>::value>() );
+      else
+         return 0;
+   }
+
+   /**
+    * Packed size of every value of type T, or 0 if it depends on the value.
+    *
+    * Deduced for primitives, std::array, std::pair, std::tuple and
+    * EOSLIB_SERIALIZE types. Anything else is variable unless it specializes
+    * this trait, which asserts that every value packs to that many bytes:
+    * pack() trusts it and writes without bounds checks. Aggregates serialized
+    * through boost::pfr are not deduced, since a hand written operator<< may
+    * override the field by field encoding; list their fields with
+    * EOSLIB_SERIALIZE to opt them in.
+    *
+    * @tparam T - The type to be checked
+    */
+   template<typename T>
+   struct fixed_pack_size : std::integral_constant<size_t, deduce_fixed_pack_size<T>()> {};
+
+   /**
+    * Position of a stream over a buffer whose bounds were checked once up front
+    *
+    * @tparam Ptr - char* for writing, const char* for reading
+    */
+   template<typename Ptr>
+   struct unchecked {};
+}
+
+/**
+ *  A data stream that reads and writes without bounds checks, used by pack()
+ *  and unpack() once the whole value is known to fit
+ *
+ *  @tparam Ptr - char* for writing, const char* for reading
+ */
+template<typename Ptr>
+class datastream<_datastream_detail::unchecked<Ptr>> {
+   public:
+      explicit datastream( Ptr start ) : _pos(start) {}
+
+      inline void skip( size_t s ){ _pos += s; }
+
+      inline bool read( char* d, size_t s ) {
+        memcpy( d, _pos, s );
+        _pos += s;
+        return true;
+      }
+
+      inline bool write( const char* d, size_t s ) {
+        memcpy( (void*)_pos, d, s );
+        _pos += s;
+        return true;
+      }
+
+      inline bool put( char c ) {
+        *_pos = c;
+        ++_pos;
+        return true;
+      }
+
+      inline bool get( unsigned char& c ) { return get( *(char*)&c ); }
+
+      inline bool get( char& c ) {
+        c = *_pos;
+        ++_pos;
+        return true;
+      }
+
+      Ptr pos()const { return _pos; }
+   private:
+      Ptr _pos;
+};
+
 /**
  *  Serialize a string into a stream
  *
@@ -494,12 +672,11 @@ DataStream& operator << ( DataStream& ds, const std::string& v ) {
  */
 template<typename DataStream>
 DataStream& operator >> ( DataStream& ds, std::string& v ) {
-   std::vector<char> tmp;
-   ds >> tmp;
-   if( tmp.size() )
-      v = std::string(tmp.data(),tmp.data()+tmp.size());
-   else
-      v = std::string();
+   unsigned_int s;
+   ds >> s;
+   eosio::check( ds.remaining() >= s.value, "read" );
+   v.assign( ds.pos(), s.value );
+   ds.skip( s.value );
    return ds;
 }
 
@@ -515,8 +692,12 @@ DataStream& operator >> ( DataStream& ds, std::string& v ) {
  */
 template<typename DataStream, typename T, std::size_t N>
 DataStream& operator << ( DataStream& ds, const std::array<T,N>& v ) {
-   for( const auto& i : v )
-      ds << i;
+   if constexpr( _datastream_detail::is_bulk_copyable<T>() ) {
+      ds.write( (const char*)v.data(), sizeof(v) );
+   } else {
+      for( const auto& i : v )
+         ds << i;
+   }
    return ds;
 }
 
@@ -534,40 +715,13 @@ DataStream& operator << ( DataStream& ds, const std::array<T,N>& v ) {
  */
 template<typename DataStream, typename T, std::size_t N>
 DataStream& operator >> ( DataStream& ds, std::array<T,N>& v ) {
-   for( auto& i : v )
-      ds >> i;
-   return ds;
-}
-
-namespace _datastream_detail {
-   /**
-    * Check if type T is a pointer
-    *
-    * @brief Check if type T is a pointer
-    * @tparam T - The type to be checked
-    * @return true if T is a pointer
-    * @return false otherwise
-    */
-   template<typename T>
-   constexpr bool is_pointer() {
-      return std::is_pointer<T>::value ||
-             std::is_null_pointer<T>::value ||
-             std::is_member_pointer<T>::value;
-   }
-
-   /**
-    * Check if type T is a primitive type
-    *
-    * @brief Check if type T is a primitive type
-    * @tparam T - The type to be checked
-    * @return true if T is a primitive type
-    * @return false otherwise
-    */
-   template<typename T>
-   constexpr bool is_primitive() {
-      return std::is_arithmetic<T>::value ||
-             std::is_enum<T>::value;
+   if constexpr( _datastream_detail::is_bulk_copyable<T>() ) {
+      ds.read( (char*)v.data(), sizeof(v) );
+   } else {
+      for( auto& i : v )
+         ds >> i;
    }
+   return ds;
 }
 
 /**
@@ -697,8 +851,12 @@ DataStream& operator << ( DataStream& ds, const std::vector<char>& v ) {
 template<typename DataStream, typename T>
 DataStream& operator << ( DataStream& ds, const std::vector<T>& v ) {
    ds << unsigned_int( v.size() );
-   for( const auto& i : v )
-      ds << i;
+   if constexpr( _datastream_detail::is_bulk_copyable<T>() ) {
+      ds.write( (const char*)v.data(), v.size() * sizeof(T) );
+   } else {
+      for( const auto& i : v )
+         ds << i;
+   }
    return ds;
 }
 
@@ -715,8 +873,9 @@ template<typename DataStream>
 DataStream& operator >> ( DataStream& ds, std::vector<char>& v ) {
    unsigned_int s;
    ds >> s;
-   v.resize( s.value );
-   ds.read( v.data(), v.size() );
+   eosio::check( ds.remaining() >= s.value, "read" );
+   v.assign( ds.pos(), ds.pos() + s.value );
+   ds.skip( s.value );
    return ds;
 }
 
@@ -734,9 +893,17 @@ template<typename DataStream, typename T>
 DataStream& operator >> ( DataStream& ds, std::vector<T>& v ) {
    unsigned_int s;
    ds >> s;
-   v.resize(s.value);
-   for( auto& i : v )
-      ds >> i;
+   if constexpr( _datastream_detail::is_bulk_copyable<T>() ) {
+      // checked before resizing, so that a corrupt length cannot trigger a huge allocation
+      eosio::check( ds.remaining() / sizeof(T) >= s.value, "read" );
+      v.resize( s.value );
+      memcpy( (char*)v.data(), ds.pos(), s.value * sizeof(T) );
+      ds.skip( s.value * sizeof(T) );
+   } else {
+      v.resize(s.value);
+      for( auto& i : v )
+         ds >> i;
+   }
    return ds;
 }
 
@@ -931,6 +1098,30 @@ DataStream& operator>>( DataStream& ds, T& v ) {
    return ds;
 }
 
+/**
+ * Unpack data inside a fixed size buffer into an existing object
+ *
+ * @ingroup datastream
+ * @brief Unpack data inside a fixed size buffer into an existing object
+ * @details Types with a fixed packed size are checked against the buffer
+ * once and then read without per-field bounds checks
+ * @tparam T - Type of the unpacked data
+ * @param buffer - Pointer to the buffer
+ * @param len - Length of the buffer
+ * @param value - The destination for the unpacked data
+ */
+template<typename T>
+void unpack( const char* buffer, size_t len, T& value ) {
+   if constexpr( _datastream_detail::fixed_pack_size<T>::value != 0 ) {
+      eosio::check( len >= _datastream_detail::fixed_pack_size<T>::value, "read" );
+      datastream<_datastream_detail::unchecked<const char*>> ds(buffer);
+      ds >> value;
+   } else {
+      datastream<const char*> ds(buffer,len);
+      ds >> value;
+   }
+}
+
 /**
  * Unpack data inside a fixed size buffer as T
  *
@@ -944,8 +1135,7 @@ DataStream& operator>>( DataStream& ds, T& v ) {
 template<typename T>
 T unpack( const char* buffer, size_t len ) {
    T result;
-   datastream<const char*> ds(buffer,len);
-   ds >> result;
+   unpack( buffer, len, result );
    return result;
 }
 
@@ -974,9 +1164,37 @@ T unpack( const std::vector<char>& bytes ) {
  */
 template<typename T>
 size_t pack_size( const T& value ) {
-  datastream<size_t> ps;
-  ps << value;
-  return ps.tellp();
+  if constexpr( _datastream_detail::fixed_pack_size<T>::value != 0 ) {
+    return _datastream_detail::fixed_pack_size<T>::value;
+  } else {
+    datastream<size_t> ps;
+    ps << value;
+    return ps.tellp();
+  }
+}
+
+/**
+ * Pack data into a fixed size buffer
+ *
+ * @ingroup datastream
+ * @brief Pack data into a fixed size buffer
+ * @details Types with a fixed packed size are checked against the buffer
+ * once and then written without per-field bounds checks
+ * @tparam T - Type of the data to be packed
+ * @param buffer - Pointer to the buffer
+ * @param len - Length of the buffer, at least pack_size(value)
+ * @param value - Data to be packed
+ */
+template<typename T>
+void pack( char* buffer, size_t len, const T& value ) {
+  if constexpr( _datastream_detail::fixed_pack_size<T>::value != 0 ) {
+    eosio::check( len >= _datastream_detail::fixed_pack_size<T>::value, "write" );
+    datastream<_datastream_detail::unchecked<char*>> ds(buffer);
+    ds << value;
+  } else {
+    datastream<char*> ds( buffer, len );
+    ds << value;
+  }
 }
 
 /**
@@ -993,8 +1211,132 @@ std::vector<char> pack( const T& value ) {
   std::vector<char> result;
   result.resize(pack_size(value));
 
-  datastream<char*> ds( result.data(), result.size() );
-  ds << value;
+  pack( result.data(), result.size(), value );
   return result;
 }
+
+template<typename T>
+class binary_extension;
+
+namespace _datastream_detail {
+   template<typename T>
+   struct is_binary_extension : std::false_type {};
+
+   template<typename T>
+   struct is_binary_extension<binary_extension<T>> : std::true_type {};
+
+   template<typename T>
+   struct is_sequence : std::false_type {};
+
+   template<>
+   struct is_sequence<std::string> : std::true_type {};
+
+   template<typename T>
+   struct is_sequence<std::vector<T>> : std::true_type {};
+
+   template<typename T, typename DataStream>
+   void skip( DataStream& ds );
+
+   template<typename T, typename DataStream, std::size_t... I>
+   void skip_fields( DataStream& ds, std::index_sequence<I...> ) {
+      ( skip<boost::pfr::tuple_element_t<I, T>>( ds ), ... );
+   }
+
+   /**
+    * Move a stream past a serialized T without decoding it
+    *
+    * Fixed size types, strings, vectors, binary extensions and reflected
+    * aggregates are skipped without allocating. Anything else is decoded
+    * into a temporary.
+    *
+    * @tparam T - The type serialized at the current position
+    * @param ds - The stream to advance
+    */
+   template<typename T, typename DataStream>
+   void skip( DataStream& ds ) {
+      if constexpr( fixed_pack_size<T>::value != 0 ) {
+         eosio::check( ds.remaining() >= fixed_pack_size<T>::value, "read" );
+         ds.skip( fixed_pack_size<T>::value );
+      } else if constexpr( is_sequence<T>::value ) {
+         using value_type = typename T::value_type;
+         unsigned_int s;
+         ds >> s;
+         if constexpr( fixed_pack_size<value_type>::value != 0 ) {
+            eosio::check( ds.remaining() / fixed_pack_size<value_type>::value >= s.value, "read" );
+            ds.skip( s.value * fixed_pack_size<value_type>::value );
+         } else {
+            for( uint32_t i = 0; i < s.value; ++i )
+               skip<value_type>( ds );
+         }
+      } else if constexpr( is_binary_extension<T>::value ) {
+         if( ds.remaining() )
+            skip<typename T::value_type>( ds );
+      } else if constexpr( std::is_class<T>::value && std::is_aggregate<T>::value && !has_declared_pack_size<T>::value ) {
+         skip_fields<T>( ds, std::make_index_sequence<boost::pfr::tuple_size_v<T>>() );
+      } else {
+         T value;
+         ds >> value;
+      }
+   }
+
+   /**
+    * Position of field J among the requested fields I..., or sizeof...(I) if it is not requested
+    */
+   template<std::size_t J, std::size_t... I>
+   constexpr std::size_t field_position() {
+      constexpr std::size_t fields[] = { I... };
+      for( std::size_t pos = 0; pos < sizeof...(I); ++pos )
+         if( fields[pos] == J )
+            return pos;
+      return sizeof...(I);
+   }
+
+   template<std::size_t... I>
+   constexpr bool strictly_increasing() {
+      constexpr std::size_t fields[] = { I... };
+      for( std::size_t pos = 1; pos < sizeof...(I); ++pos )
+         if( fields[pos - 1] >= fields[pos] )
+            return false;
+      return true;
+   }
+
+   template<typename T, std::size_t... I, typename DataStream, typename Tuple, std::size_t... J>
+   void unpack_fields( DataStream& ds, Tuple& result, std::index_sequence<J...> ) {
+      ( [&]() {
+         constexpr std::size_t pos = field_position<J, I...>();
+         if constexpr( pos < sizeof...(I) )
+            ds >> std::get<pos>( result );
+         else
+            skip<boost::pfr::tuple_element_t<J, T>>( ds );
+      }(), ... );
+   }
+}
+
+/**
+ * Unpack only some fields of a T packed inside a fixed size buffer
+ *
+ * @ingroup datastream
+ * @brief Unpack a projection of T
+ * @details Fields before the last requested one are skipped without being
+ * decoded, and fields after it are not read at all. T must be an aggregate
+ * serialized field by field, i.e. without EOSLIB_SERIALIZE
+ * @tparam T - Type of the packed data
+ * @tparam I - Indices of the requested fields, in increasing order
+ * @param buffer - Pointer to the buffer
+ * @param len - Length of the buffer
+ * @return std::tuple - The requested fields, in the order of I
+ */
+template<typename T, std::size_t... I>
+std::tuple<boost::pfr::tuple_element_t<I, T>...> unpack_fields( const char* buffer, size_t len ) {
+   static_assert( sizeof...(I) > 0, "at least one field must be requested" );
+   static_assert( _datastream_detail::strictly_increasing<I...>(), "fields must be requested in increasing order" );
+   static_assert( std::is_aggregate<T>::value && !_datastream_detail::has_declared_pack_size<T>::value,
+                  "only reflected aggregates can be unpacked field by field" );
+
+   constexpr std::size_t fields[] = { I... };
+   std::tuple<boost::pfr::tuple_element_t<I, T>...> result;
+   datastream<const char*> ds( buffer, len );
+   _datastream_detail::unpack_fields<T, I...>( ds, result, std::make_index_sequence<fields[sizeof...(I) - 1] + 1>() );
+   return result;
+}
 }
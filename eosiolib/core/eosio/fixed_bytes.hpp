@@ -386,5 +386,10 @@ namespace eosio {
       return ds;
    }
 
+   namespace _datastream_detail {
+      template<size_t Size>
+      struct fixed_pack_size<fixed_bytes<Size>> : std::integral_constant<size_t, Size> {};
+   }
+
    /// @endcond
 }
@@ -271,5 +271,5 @@ namespace eosio {
 
    /// @endcond
 
-   static iostream cout;
+   [[maybe_unused]] static iostream cout;
 }
@@ -4,9 +4,20 @@
 #include <boost/preprocessor/seq/seq.hpp>
 #include <boost/preprocessor/stringize.hpp>
 
+#include <cstddef>
+
+namespace eosio { namespace _datastream_detail {
+   // defined in datastream.hpp
+   template<typename Void, typename... Ts>
+   constexpr size_t fixed_pack_size_of_members();
+} }
+
 #define EOSLIB_REFLECT_MEMBER_OP( r, OP, elem ) \
   OP t.elem
 
+#define EOSLIB_REFLECT_MEMBER_TYPE( r, TYPE, elem ) \
+  , decltype(TYPE::elem)
+
 /**
  *  @defgroup serialize Serialize
  *  @ingroup core
@@ -14,13 +25,18 @@
  */
 
 /**
- *  Defines serialization and deserialization for a class
+ *  Defines serialization and deserialization for a class, and its packed size
+ *  when every member has a fixed packed size
  *
  *  @ingroup serialize
  *  @param TYPE - the class to have its serialization and deserialization defined
  *  @param MEMBERS - a sequence of member names.  (field1)(field2)(field3)
  */
 #define EOSLIB_SERIALIZE( TYPE,  MEMBERS ) \
+ static constexpr size_t eosio_fixed_pack_size() { \
+    return ::eosio::_datastream_detail::fixed_pack_size_of_members< void \
+       BOOST_PP_SEQ_FOR_EACH( EOSLIB_REFLECT_MEMBER_TYPE, TYPE, MEMBERS )>(); \
+ }\
  template<typename DataStream> \
  friend DataStream& operator << ( DataStream& ds, const TYPE& t ){ \
     return ds BOOST_PP_SEQ_FOR_EACH( EOSLIB_REFLECT_MEMBER_OP, <<, MEMBERS );\
@@ -40,6 +56,10 @@
  *  @param MEMBERS - a sequence of member names.  (field1)(field2)(field3)
  */
 #define EOSLIB_SERIALIZE_DERIVED( TYPE, BASE, MEMBERS ) \
+ static constexpr size_t eosio_fixed_pack_size() { \
+    return ::eosio::_datastream_detail::fixed_pack_size_of_members< void, BASE \
+       BOOST_PP_SEQ_FOR_EACH( EOSLIB_REFLECT_MEMBER_TYPE, TYPE, MEMBERS )>(); \
+ }\
  template<typename DataStream> \
  friend DataStream& operator << ( DataStream& ds, const TYPE& t ){ \
     ds << static_cast<const BASE&>(t); \
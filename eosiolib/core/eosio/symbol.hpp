@@ -235,6 +235,11 @@ namespace eosio {
      return ds;
    }
 
+   namespace _datastream_detail {
+      template<>
+      struct fixed_pack_size<symbol_code> : std::integral_constant<size_t, sizeof(uint64_t)> {};
+   }
+
    /**
     *  Stores information about a symbol, the symbol can be 7 characters long.
     *
@@ -373,6 +378,11 @@ namespace eosio {
      return ds;
    }
 
+   namespace _datastream_detail {
+      template<>
+      struct fixed_pack_size<symbol> : std::integral_constant<size_t, sizeof(uint64_t)> {};
+   }
+
    /**
     *  Extended asset which stores the information of the owner of the symbol
     *
@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <string>
+#include <limits>
 #include "check.hpp"
 #include "serialize.hpp"
 
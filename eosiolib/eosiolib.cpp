@@ -71,14 +71,23 @@ namespace eosio {
    }
 
    // system.hpp
+   // the native emulator's clock can move between actions of one process, so it is never cached
    time_point current_time_point() {
+#ifdef EOSIO_NATIVE
+      return time_point(microseconds(static_cast<int64_t>(current_time())));
+#else
       static auto ct = time_point(microseconds(static_cast<int64_t>(current_time())));
       return ct;
+#endif
    }
 
    block_timestamp current_block_time() {
+#ifdef EOSIO_NATIVE
+      return block_timestamp(current_time_point());
+#else
       static auto bt = block_timestamp(current_time_point());
       return bt;
+#endif
    }
 
    std::vector<name> get_active_producers() {
@@ -41,7 +41,8 @@ namespace eosio {
          const size_t num_desired_pages = (sbrk_bytes + num_bytes + NBBP - 1) >> NBPPL2;
 
          if(num_desired_pages > current_pages) {
-            if (GROW_MEMORY(num_desired_pages - current_pages) == -1)
+            // -1 on failure, as a size_t in native builds
+            if (int32_t(GROW_MEMORY(num_desired_pages - current_pages)) == -1)
                return reinterpret_cast<void*>(-1);
          }
 
@@ -103,7 +104,10 @@ namespace eosio {
 
          // if we can expand the current memory, keep working with it
          if (current_memory->expand_memory(new_memory_start, heap_adj))
+         {
+            record_owner(new_memory_start, heap_adj, _active_heap);
             return current_memory;
+         }
 
          // ensure that any remaining unallocated memory gets cleaned up
          current_memory->cleanup_remaining();
@@ -111,9 +115,47 @@ namespace eosio {
          ++_active_heap;
          memory* const next = _available_heaps + _active_heap;
          next->init(new_memory_start, heap_adj);
+         record_owner(new_memory_start, heap_adj, _active_heap);
 
          return next;
       }
+
+      // heaps grown through sbrk always end on a wasm page boundary, so every page belongs to at most one heap
+      void record_owner(char* start, size_t size, size_t heap)
+      {
+         if (_sbrk_base == nullptr)
+            _sbrk_base = start;
+         const size_t first_page = (start - _sbrk_base) >> _page_shift;
+         const size_t end_page = (start + size - 1 - _sbrk_base) >> _page_shift;
+         for (size_t page = first_page; page <= end_page && page < _tracked_pages; ++page)
+            _page_owner[page] = heap + 1;
+      }
+
+      // the heap containing ptr, or nullptr if ptr was not allocated by malloc
+      memory* owning_heap(const char* ptr)
+      {
+         memory* const initial = _available_heaps;
+         if (initial->is_in_heap(ptr))
+            return initial;
+
+         if (_sbrk_base != nullptr && ptr >= _sbrk_base)
+         {
+            const size_t page = (ptr - _sbrk_base) >> _page_shift;
+            if (page < _tracked_pages)
+            {
+               memory* const heap = _page_owner[page] ? _available_heaps + _page_owner[page] - 1 : nullptr;
+               return heap != nullptr && heap->is_in_heap(ptr) ? heap : nullptr;
+            }
+         }
+
+         // beyond the tracked pages, only reachable in native builds
+         for (memory* heap = initial + 1; heap < _available_heaps + _heaps_actual_size && heap->is_init(); ++heap)
+         {
+            if (heap->is_in_heap(ptr))
+               return heap;
+         }
+         return nullptr;
+      }
       void* malloc(size_t size)
       {
          if (size == 0)
@@ -186,17 +228,12 @@ namespace eosio {
          if (ptr != nullptr)
          {
             char* const char_ptr = static_cast<char*>(ptr);
-            for (memory* realloc_heap = _available_heaps; realloc_heap < _available_heaps + _heaps_actual_size && realloc_heap->is_init(); ++realloc_heap)
+            if (memory* const realloc_heap = owning_heap(char_ptr))
             {
-               if (realloc_heap->is_in_heap(char_ptr))
-               {
-                  realloc_ptr = realloc_heap->realloc_in_place(char_ptr, size, &orig_ptr_size);
+               realloc_ptr = realloc_heap->realloc_in_place(char_ptr, size, &orig_ptr_size);
 
-                  if (realloc_ptr != nullptr)
-                     return realloc_ptr;
-                  else
-                     break;
-               }
+               if (realloc_ptr != nullptr)
+                  return realloc_ptr;
             }
          }
 
@@ -220,14 +257,8 @@ namespace eosio {
             return;
 
          char* const char_ptr = static_cast<char*>(ptr);
-         for (memory* free_heap = _available_heaps; free_heap < _available_heaps + _heaps_actual_size && free_heap->is_init(); ++free_heap)
-         {
-            if (free_heap->is_in_heap(char_ptr))
-            {
-               free_heap->free(char_ptr);
-               break;
-            }
-         }
+         if (memory* const free_heap = owning_heap(char_ptr))
+            free_heap->free(char_ptr);
       }
 
       void adjust_to_mem_block(size_t& size)
@@ -519,9 +550,307 @@ namespace eosio {
       size_t _active_heap;
       size_t _active_free_heap;
       static const size_t _alloc_memory_mask = size_t(1) << 31;
+      // owner of each wasm page handed out by sbrk, as heap index + 1; 1024 pages cover the 64MiB
+      // above the initial memory, well beyond what the chain grants an action
+      static const size_t _page_shift = 16;
+      static const size_t _tracked_pages = 1024;
+      char* _sbrk_base;
+      uint8_t _page_owner[_tracked_pages];
+   };
+
+   /**
+    * Segregated fits allocator, used instead of memory_manager when built with
+    * EOSIO_MALLOC_SIZE_CLASSES.
+    *
+    * Free blocks are kept in doubly linked lists by size class: one class per
+    * alignment step below 512 bytes, then 8 classes per power of two. Requests
+    * are rounded up to the lower bound of the next class, so the first block of
+    * any non-empty class at or above it fits, and a bitmap of non-empty classes
+    * finds that list in constant time. Every block has a header holding its
+    * size, whether it is allocated and whether the previous block is; free
+    * blocks repeat their size in a footer. That lets `free` coalesce with both
+    * neighbours immediately, so no list ever holds two adjacent free blocks.
+    */
+   class size_class_manager  // NOTE: Should never allocate another instance of size_class_manager
+   {
+   public:
+      // members are only zero initialized for global objects (see memory_manager), setup happens on first use
+      void* malloc(size_t size)
+      {
+         if (size == 0 || size > _max_request)
+            return nullptr;
+
+         if (!_initialized)
+            init();
+
+         const size_t block = block_size(size);
+         char* hdr = take_free(block);
+         if (hdr == nullptr)
+         {
+            if (!grow(block))
+               return nullptr;
+            hdr = take_free(block);
+         }
+         return hdr + _word;
+      }
+
+      void* realloc(void* ptr, size_t size)
+      {
+         if (ptr == nullptr)
+            return malloc(size);
+
+         if (size == 0)
+         {
+            free(ptr);
+            return nullptr;
+         }
+
+         if (size > _max_request)
+            return nullptr;
+
+         char* const hdr = static_cast<char*>(ptr) - _word;
+         const size_t block = block_size(size);
+         const size_t current = size_of(hdr);
+         if (block <= current)
+         {
+            shrink(hdr, block);
+            return ptr;
+         }
+
+         // grow in place into a free successor
+         char* const next = hdr + current;
+         if (!is_alloc(next) && current + size_of(next) >= block)
+         {
+            unlink(next, size_of(next));
+            set_header(hdr, current + size_of(next), true, prev_alloc(hdr));
+            set_prev_alloc(hdr + size_of(hdr), true);
+            shrink(hdr, block);
+            return ptr;
+         }
+
+         void* const moved = malloc(size);
+         if (moved != nullptr)
+         {
+            memcpy(moved, ptr, current - _word);
+            free(ptr);
+         }
+         return moved;
+      }
+
+      void free(void* ptr)
+      {
+         if (ptr == nullptr)
+            return;
+
+         release(static_cast<char*>(ptr) - _word);
+      }
+
+   private:
+      static constexpr size_t _word = sizeof(size_t);
+      // payload alignment, big enough for the two free list links
+      static constexpr size_t _align = 2 * (sizeof(void*) > _word ? sizeof(void*) : _word);
+      // header, two links and footer
+      static constexpr size_t _min_block = 2 * _align;
+      static constexpr size_t _max_request = ~size_t(0) >> 2;
+
+      static constexpr size_t _alloc_bit = 1;
+      static constexpr size_t _prev_alloc_bit = 2;
+      static constexpr size_t _flags_mask = _alloc_bit | _prev_alloc_bit;
+
+      static constexpr size_t _small_limit = 512;
+      static constexpr size_t _small_limit_log2 = 9;
+      static constexpr size_t _small_classes = _small_limit / _align;
+      static constexpr size_t _splits_log2 = 3;
+      static constexpr size_t _classes = _small_classes + (sizeof(size_t) * 8 - _small_limit_log2) * (1 << _splits_log2);
+      static constexpr size_t _bitmap_words = (_classes + 63) / 64;
+
+      static constexpr size_t _initial_heap_size = 8192;
+      static constexpr size_t _grow_granularity = 16 * 1024;
+
+      static size_t align_up(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+
+      static size_t block_size(size_t request)
+      {
+         const size_t size = align_up(request + _word, _align);
+         return size < _min_block ? _min_block : size;
+      }
+
+      static size_t log2(size_t v) { return 63 - __builtin_clzll(v); }
+
+      // class holding blocks of `size` bytes
+      static size_t class_of(size_t size)
+      {
+         if (size < _small_limit)
+            return size / _align;
+         const size_t fl = log2(size);
+         const size_t sl = (size >> (fl - _splits_log2)) & ((1 << _splits_log2) - 1);
+         return _small_classes + ((fl - _small_limit_log2) << _splits_log2) + sl;
+      }
+
+      // first class whose every block holds `size` bytes
+      static size_t search_class_of(size_t size)
+      {
+         if (size >= _small_limit)
+            size += (size_t(1) << (log2(size) - _splits_log2)) - 1;
+         return class_of(size);
+      }
+
+      static size_t& header(char* hdr) { return *reinterpret_cast<size_t*>(hdr); }
+      static size_t size_of(char* hdr) { return header(hdr) & ~_flags_mask; }
+      static bool is_alloc(char* hdr) { return header(hdr) & _alloc_bit; }
+      static bool prev_alloc(char* hdr) { return header(hdr) & _prev_alloc_bit; }
+
+      static void set_header(char* hdr, size_t size, bool alloc, bool prev)
+      {
+         header(hdr) = size | (alloc ? _alloc_bit : 0) | (prev ? _prev_alloc_bit : 0);
+         if (!alloc)
+            *reinterpret_cast<size_t*>(hdr + size - _word) = size;
+      }
+
+      static void set_prev_alloc(char* hdr, bool prev)
+      {
+         if (prev)
+            header(hdr) |= _prev_alloc_bit;
+         else
+            header(hdr) &= ~_prev_alloc_bit;
+      }
+
+      static char*& next_link(char* hdr) { return *reinterpret_cast<char**>(hdr + _word); }
+      static char*& prev_link(char* hdr) { return *reinterpret_cast<char**>(hdr + _word + sizeof(char*)); }
+
+      void link(char* hdr, size_t size)
+      {
+         const size_t cls = class_of(size);
+         next_link(hdr) = _heads[cls];
+         prev_link(hdr) = nullptr;
+         if (_heads[cls] != nullptr)
+            prev_link(_heads[cls]) = hdr;
+         _heads[cls] = hdr;
+         _bitmap[cls / 64] |= uint64_t(1) << (cls % 64);
+      }
+
+      void unlink(char* hdr, size_t size)
+      {
+         const size_t cls = class_of(size);
+         char* const next = next_link(hdr);
+         char* const prev = prev_link(hdr);
+         if (next != nullptr)
+            prev_link(next) = prev;
+         if (prev != nullptr)
+            next_link(prev) = next;
+         else if ((_heads[cls] = next) == nullptr)
+            _bitmap[cls / 64] &= ~(uint64_t(1) << (cls % 64));
+      }
+
+      // pop a free block of at least `block` bytes and allocate its first `block` bytes
+      char* take_free(size_t block)
+      {
+         size_t cls = search_class_of(block);
+         size_t word = cls / 64;
+         if (word >= _bitmap_words)
+            return nullptr;
+         uint64_t bits = _bitmap[word] & (~uint64_t(0) << (cls % 64));
+         while (bits == 0)
+         {
+            if (++word == _bitmap_words)
+               return nullptr;
+            bits = _bitmap[word];
+         }
+         char* const hdr = _heads[word * 64 + __builtin_ctzll(bits)];
+         const size_t size = size_of(hdr);
+         unlink(hdr, size);
+         // free blocks always follow an allocated one
+         set_header(hdr, size, true, true);
+         set_prev_alloc(hdr + size, true);
+         shrink(hdr, block);
+         return hdr;
+      }
+
+      // give back the tail of an allocated block beyond `block` bytes
+      void shrink(char* hdr, size_t block)
+      {
+         const size_t size = size_of(hdr);
+         if (size - block < _min_block)
+            return;
+         set_header(hdr, block, true, prev_alloc(hdr));
+         char* const rest = hdr + block;
+         set_header(rest, size - block, true, true);
+         release(rest);
+      }
+
+      // free an allocated block, merging it with free neighbours
+      void release(char* hdr)
+      {
+         size_t size = size_of(hdr);
+         char* const next = hdr + size;
+         if (!is_alloc(next))
+         {
+            unlink(next, size_of(next));
+            size += size_of(next);
+         }
+         if (!prev_alloc(hdr))
+         {
+            const size_t prev_size = *reinterpret_cast<size_t*>(hdr - _word);
+            hdr -= prev_size;
+            unlink(hdr, prev_size);
+            size += prev_size;
+         }
+         set_header(hdr, size, false, true);
+         set_prev_alloc(hdr + size, false);
+         link(hdr, size);
+      }
+
+      // lay out [start, start + size) as one free block followed by an allocated end marker
+      bool add_region(char* start, size_t size)
+      {
+         const size_t base = reinterpret_cast<size_t>(start);
+         char* const first = reinterpret_cast<char*>(align_up(base + _word, _align) - _word);
+         char* const end = reinterpret_cast<char*>(((base + size) & ~(_align - 1)) - _word);
+         if (end < first + _min_block)
+            return false;
+         set_header(first, end - first, true, true);
+         set_header(end, 0, true, true);
+         _top_end = end + _word;
+         release(first);
+         return true;
+      }
+
+      bool grow(size_t block)
+      {
+         const size_t size = align_up(block + _align, _grow_granularity);
+         char* const start = static_cast<char*>(sbrk(size));
+         if (reinterpret_cast<intptr_t>(start) == -1)
+            return false;
+         if (start != _top_end)
+            return add_region(start, size);
+
+         // contiguous with the last region: its end marker becomes the header of the new space
+         char* const hdr = _top_end - _word;
+         set_header(hdr, size, true, prev_alloc(hdr));
+         set_header(hdr + size, 0, true, true);
+         _top_end += size;
+         release(hdr);
+         return true;
+      }
+
+      void init()
+      {
+         _initialized = true;
+         add_region(_initial_heap, _initial_heap_size);
+      }
+
+      alignas(16) char _initial_heap[_initial_heap_size];
+      char* _heads[_classes];
+      uint64_t _bitmap[_bitmap_words];
+      char* _top_end;
+      bool _initialized;
    };
-   
+
+#ifdef EOSIO_MALLOC_SIZE_CLASSES
+   size_class_manager memory_heap;
+#else
    memory_manager memory_heap;
+#endif
 } /// namespace eosio
 
 extern "C" {
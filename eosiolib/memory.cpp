@@ -1,37 +1,174 @@
 #include <cstring>
+#include <cstdint>
+
+// EOSIO_CMEM_NO_SIMD forces the 64-bit word kernels even when the target has vector instructions
+#if defined(__wasm_simd128__) && !defined(EOSIO_CMEM_NO_SIMD)
+#include <wasm_simd128.h>
+#define EOSIO_CMEM_WASM_SIMD
+#elif defined(__SSE2__) && !defined(EOSIO_CMEM_NO_SIMD)
+#include <emmintrin.h>
+#define EOSIO_CMEM_SSE2
+#endif
+
+// keep the compiler from turning the loops below back into calls to the functions they implement
+#if defined(__has_attribute)
+#if __has_attribute(no_builtin)
+#define EOSIO_CMEM_NO_BUILTIN __attribute__((no_builtin))
+#endif
+#endif
+#ifndef EOSIO_CMEM_NO_BUILTIN
+#define EOSIO_CMEM_NO_BUILTIN
+#endif
+
+namespace {
+   // wasm and the native targets allow unaligned access, so the kernels never align their pointers
+   typedef uint64_t __attribute__((__may_alias__, __aligned__(1))) unaligned_u64;
+   typedef uint32_t __attribute__((__may_alias__, __aligned__(1))) unaligned_u32;
+
+   constexpr size_t block_size = 16;
+
+   inline uint64_t load64( const uint8_t* p ) { return *reinterpret_cast<const unaligned_u64*>(p); }
+   inline void store64( uint8_t* p, uint64_t v ) { *reinterpret_cast<unaligned_u64*>(p) = v; }
+   inline uint32_t load32( const uint8_t* p ) { return *reinterpret_cast<const unaligned_u32*>(p); }
+   inline void store32( uint8_t* p, uint32_t v ) { *reinterpret_cast<unaligned_u32*>(p) = v; }
+
+   // loads the whole block before storing it, which memmove relies on
+   inline void copy_block( uint8_t* dst, const uint8_t* src ) {
+#if defined(EOSIO_CMEM_WASM_SIMD)
+      wasm_v128_store( dst, wasm_v128_load( src ) );
+#elif defined(EOSIO_CMEM_SSE2)
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(dst), _mm_loadu_si128( reinterpret_cast<const __m128i*>(src) ) );
+#else
+      const uint64_t lo = load64( src );
+      const uint64_t hi = load64( src + 8 );
+      store64( dst, lo );
+      store64( dst + 8, hi );
+#endif
+   }
+
+   inline void fill_block( uint8_t* dst, uint64_t pattern ) {
+#if defined(EOSIO_CMEM_WASM_SIMD)
+      wasm_v128_store( dst, wasm_i64x2_splat( pattern ) );
+#elif defined(EOSIO_CMEM_SSE2)
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(dst), _mm_set1_epi64x( pattern ) );
+#else
+      store64( dst, pattern );
+      store64( dst + 8, pattern );
+#endif
+   }
+
+   inline bool equal_block( const uint8_t* a, const uint8_t* b ) {
+#if defined(EOSIO_CMEM_WASM_SIMD)
+      return wasm_i8x16_all_true( wasm_i8x16_eq( wasm_v128_load( a ), wasm_v128_load( b ) ) );
+#elif defined(EOSIO_CMEM_SSE2)
+      const __m128i eq = _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>(a) ),
+                                         _mm_loadu_si128( reinterpret_cast<const __m128i*>(b) ) );
+      return _mm_movemask_epi8( eq ) == 0xffff;
+#else
+      return ((load64( a ) ^ load64( b )) | (load64( a + 8 ) ^ load64( b + 8 ))) == 0;
+#endif
+   }
+
+   EOSIO_CMEM_NO_BUILTIN
+   inline int compare_bytes( const uint8_t* p1, const uint8_t* p2, size_t n ) {
+      for ( size_t i=0; i < n; i++ ) {
+         if ( p1[i] < p2[i] )
+            return -1;
+         else if ( p1[i] > p2[i] )
+            return 1;
+      }
+      return 0;
+   }
+}
 
 extern "C" {
+   EOSIO_CMEM_NO_BUILTIN
    void* memset( void* ptr, int c, size_t n ) {
       uint8_t* p = (uint8_t*)ptr;
-      for ( size_t i=0; i < n; i++ )
-         p[i] = (uint8_t)c;
+      const uint64_t pattern = uint64_t(uint8_t(c)) * 0x0101010101010101ull;
+      if ( n >= block_size ) {
+         for ( size_t i=0; i < n - block_size; i += block_size )
+            fill_block( p + i, pattern );
+         // the last block may overlap the previous one
+         fill_block( p + n - block_size, pattern );
+      } else if ( n >= 8 ) {
+         store64( p, pattern );
+         store64( p + n - 8, pattern );
+      } else if ( n >= 4 ) {
+         store32( p, uint32_t(pattern) );
+         store32( p + n - 4, uint32_t(pattern) );
+      } else {
+         for ( size_t i=0; i < n; i++ )
+            p[i] = (uint8_t)c;
+      }
       return ptr;
    }
+
+   EOSIO_CMEM_NO_BUILTIN
    void* memcpy( void* ptr1, const void* ptr2, size_t n ) {
       uint8_t* p1 = (uint8_t*)ptr1;
       const uint8_t* p2 = (const uint8_t*)ptr2;
-      for ( size_t i=0; i < n; i++ )
-         p1[i] = p2[i];
+      if ( n >= block_size ) {
+         for ( size_t i=0; i < n - block_size; i += block_size )
+            copy_block( p1 + i, p2 + i );
+         // the last block may overlap the previous one, which is fine as the buffers do not overlap
+         copy_block( p1 + n - block_size, p2 + n - block_size );
+      } else if ( n >= 8 ) {
+         const uint64_t head = load64( p2 );
+         const uint64_t tail = load64( p2 + n - 8 );
+         store64( p1, head );
+         store64( p1 + n - 8, tail );
+      } else if ( n >= 4 ) {
+         const uint32_t head = load32( p2 );
+         const uint32_t tail = load32( p2 + n - 4 );
+         store32( p1, head );
+         store32( p1 + n - 4, tail );
+      } else {
+         for ( size_t i=0; i < n; i++ )
+            p1[i] = p2[i];
+      }
       return ptr1;
    }
+
+   EOSIO_CMEM_NO_BUILTIN
    void* memmove( void* ptr1, const void* ptr2, size_t n ) {
       uint8_t* p1 = (uint8_t*)ptr1;
       const uint8_t* p2 = (const uint8_t*)ptr2;
-      uint8_t* p3 = new uint8_t[n];
-      memcpy( p3, p2, n );
-      memcpy( p1, p3, n );
-      delete[] p3;
+      if ( p1 == p2 || n == 0 )
+         return ptr1;
+
+      // each block is read before it is written, so copying away from the overlap is safe
+      if ( p1 < p2 || p1 >= p2 + n ) {
+         size_t i = 0;
+         for ( ; i + block_size <= n; i += block_size )
+            copy_block( p1 + i, p2 + i );
+         for ( ; i < n; i++ )
+            p1[i] = p2[i];
+      } else {
+         size_t i = n;
+         for ( ; i >= block_size; i -= block_size )
+            copy_block( p1 + i - block_size, p2 + i - block_size );
+         while ( i > 0 ) {
+            --i;
+            p1[i] = p2[i];
+         }
+      }
       return ptr1;
    }
+
+   EOSIO_CMEM_NO_BUILTIN
    int memcmp( const void* ptr1, const void* ptr2, size_t n ) {
       const uint8_t* p1 = (uint8_t*)ptr1;
       const uint8_t* p2 = (uint8_t*)ptr2;
-      for ( size_t i=0; i < n; i++ ) {
-         if ( p1[i] < p2[i] )
-            return -1;
-         else if ( p1[i] > p2[i] )
-            return 1;
+      size_t i = 0;
+      for ( ; i + block_size <= n; i += block_size ) {
+         if ( !equal_block( p1 + i, p2 + i ) )
+            return compare_bytes( p1 + i, p2 + i, block_size );
       }
-      return 0;
+      for ( ; i + 8 <= n; i += 8 ) {
+         if ( load64( p1 + i ) != load64( p2 + i ) )
+            return compare_bytes( p1 + i, p2 + i, 8 );
+      }
+      return compare_bytes( p1 + i, p2 + i, n - i );
    }
 }
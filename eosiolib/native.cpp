@@ -0,0 +1,1041 @@
+#include "native/eosio/native.hpp"
+#include "core/eosio/datastream.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+#include <sys/mman.h>
+
+namespace eosio { namespace native {
+   namespace {
+      // billable sizes of the chain's table objects, see chain/contract_table_objects.hpp
+      constexpr int64_t overhead_per_row_per_index_ram_bytes = 32;
+      constexpr int64_t table_billable_size = 44 + overhead_per_row_per_index_ram_bytes * 2;
+      constexpr int64_t row_billable_size   = 44 + overhead_per_row_per_index_ram_bytes * 2;
+
+      constexpr int64_t secondary_billable_size( size_t key_size ) {
+         return 24 + key_size + overhead_per_row_per_index_ram_bytes * 3;
+      }
+
+      constexpr uint32_t max_inline_action_depth = 4;
+
+      // thrown by eosio_exit to end the current action successfully
+      struct exit_signal {};
+
+      void chain_assert( bool test, const char* msg ) {
+         if( !test )
+            throw assert_failure( msg );
+      }
+
+      struct table_key {
+         uint64_t code;
+         uint64_t scope;
+         uint64_t table;
+
+         friend bool operator<( const table_key& a, const table_key& b ) {
+            return std::tie( a.code, a.scope, a.table ) < std::tie( b.code, b.scope, b.table );
+         }
+      };
+
+      struct context {
+         uint64_t                                          receiver = 0;
+         const action*                                     act = nullptr;
+         std::vector<permission_level>                     authorization;
+         std::vector<uint64_t>*                            notified = nullptr;
+         std::vector<std::pair<uint64_t, action>>*         inlines = nullptr;
+         uint64_t                                          sender = 0;
+         std::string                                       console;
+
+         bool in_notify()const { return act && act->account.value != receiver; }
+
+         bool has_auth( uint64_t account )const {
+            for( const auto& p : authorization )
+               if( p.actor.value == account )
+                  return true;
+            return false;
+         }
+      };
+
+      struct state;
+      state& chain();
+
+      void record_undo( std::function<void()> undo );
+      void charge( uint64_t payer, int64_t delta );
+
+      // position of a row or table in the iterator cache of the current action
+      struct cached_iterator {
+         int32_t  iterator = -1;
+         uint32_t epoch = 0;
+      };
+
+      struct row : cached_iterator {
+         uint64_t          primary;
+         uint64_t          payer;
+         std::vector<char> value;
+
+         row( uint64_t primary, uint64_t payer, std::vector<char> value )
+            : primary( primary ), payer( payer ), value( std::move( value ) ) {}
+      };
+
+      struct table : cached_iterator {
+         table_key               key;
+         uint64_t                payer = 0;
+         std::map<uint64_t, row> rows;
+
+         // updates keep the row object, and with it its iterator
+         void put( row r ) {
+            auto itr = rows.find( r.primary );
+            if( itr != rows.end() ) {
+               record_undo( [this, old = itr->second]() { put( old ); } );
+               itr->second.payer = r.payer;
+               itr->second.value = std::move( r.value );
+            } else {
+               record_undo( [this, pk = r.primary]() { rows.erase( pk ); } );
+               rows.emplace( r.primary, std::move( r ) );
+            }
+         }
+
+         void erase( uint64_t pk ) {
+            auto itr = rows.find( pk );
+            record_undo( [this, old = itr->second]() { put( old ); } );
+            rows.erase( itr );
+         }
+      };
+
+      template<typename K>
+      struct secondary_row : cached_iterator {
+         uint64_t primary;
+         K        secondary;
+         uint64_t payer;
+
+         secondary_row( uint64_t primary, const K& secondary, uint64_t payer )
+            : primary( primary ), secondary( secondary ), payer( payer ) {}
+      };
+
+      template<typename K>
+      struct secondary_table : cached_iterator {
+         table_key                                key;
+         uint64_t                                 payer = 0;
+         std::map<uint64_t, secondary_row<K>>     rows;    // by primary key
+         std::set<std::pair<K, uint64_t>>         ordered; // by secondary key, then primary key
+
+         void put( const secondary_row<K>& r ) {
+            auto itr = rows.find( r.primary );
+            if( itr != rows.end() ) {
+               record_undo( [this, old = itr->second]() { put( old ); } );
+               ordered.erase( { itr->second.secondary, r.primary } );
+               itr->second.secondary = r.secondary;
+               itr->second.payer = r.payer;
+            } else {
+               record_undo( [this, pk = r.primary]() { erase( pk ); } );
+               rows.emplace( r.primary, r );
+            }
+            ordered.emplace( r.secondary, r.primary );
+         }
+
+         void erase( uint64_t pk ) {
+            auto itr = rows.find( pk );
+            record_undo( [this, old = itr->second]() { put( old ); } );
+            ordered.erase( { itr->second.secondary, pk } );
+            rows.erase( itr );
+         }
+      };
+
+      /**
+       * Per-action mapping between the integer iterators handed to the contract
+       * and rows, following the chain: the same row always gets the same
+       * iterator, and the end iterator of the n-th table seen is -(n + 2).
+       * Rows and tables remember their iterator together with the epoch it
+       * was handed out in, so lookups are O(1) and clearing only bumps the
+       * epoch.
+       */
+      template<typename Table, typename Row>
+      class iterator_cache {
+      public:
+         int end_iterator( Table& t ) {
+            if( t.epoch != _epoch ) {
+               t.epoch = _epoch;
+               t.iterator = -int(_tables.size() + 2);
+               _tables.push_back( &t );
+            }
+            return t.iterator;
+         }
+
+         Table& end_table( int itr ) {
+            size_t i = -(itr + 2);
+            chain_assert( i < _tables.size(), "not a valid end iterator" );
+            return *_tables[i];
+         }
+
+         int add( Table& t, Row& r ) {
+            if( r.epoch != _epoch ) {
+               r.epoch = _epoch;
+               r.iterator = _objects.size();
+               _objects.emplace_back( &t, &r );
+               end_iterator( t );
+            }
+            return r.iterator;
+         }
+
+         std::pair<Table*, Row*> get( int itr ) {
+            chain_assert( itr != -1, "invalid iterator" );
+            chain_assert( itr >= 0, "dereference of end iterator" );
+            chain_assert( size_t(itr) < _objects.size(), "iterator out of range" );
+            chain_assert( _objects[itr].second, "dereference of deleted object" );
+            return _objects[itr];
+         }
+
+         void remove( int itr ) {
+            _objects[itr].second->epoch = 0;
+            _objects[itr].second = nullptr;
+         }
+
+         void clear() {
+            ++_epoch;
+            _tables.clear();
+            _objects.clear();
+         }
+
+      private:
+         uint32_t                               _epoch = 1;
+         std::vector<Table*>                    _tables;
+         std::vector<std::pair<Table*, Row*>>   _objects;
+      };
+
+      template<typename K>
+      void validate_key( const K& ) {}
+
+      void validate_key( const double& k ) {
+         chain_assert( !std::isnan( k ), "NaN is not an allowed value for a secondary key" );
+      }
+
+      void validate_key( const long double& k ) {
+         chain_assert( !std::isnan( k ), "NaN is not an allowed value for a secondary key" );
+      }
+
+      template<typename K>
+      class secondary_index {
+      public:
+         using table_type = secondary_table<K>;
+         using row_type   = secondary_row<K>;
+
+         static constexpr int64_t billable_size = secondary_billable_size( sizeof(K) );
+
+         int32_t store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const K& secondary );
+         void update( int32_t iterator, uint64_t payer, const K& secondary );
+         void remove( int32_t iterator );
+         int32_t next( int32_t iterator, uint64_t* primary );
+         int32_t previous( int32_t iterator, uint64_t* primary );
+         int32_t find_primary( uint64_t code, uint64_t scope, uint64_t table, K& secondary, uint64_t primary );
+         int32_t find_secondary( uint64_t code, uint64_t scope, uint64_t table, const K& secondary, uint64_t* primary );
+         int32_t lowerbound( uint64_t code, uint64_t scope, uint64_t table, K& secondary, uint64_t* primary );
+         int32_t upperbound( uint64_t code, uint64_t scope, uint64_t table, K& secondary, uint64_t* primary );
+         int32_t end( uint64_t code, uint64_t scope, uint64_t table );
+
+         void clear_iterators() { _iterators.clear(); }
+
+      private:
+         table_type* find_table( uint64_t code, uint64_t scope, uint64_t table ) {
+            auto itr = _tables.find( { code, scope, table } );
+            return itr == _tables.end() || itr->second.rows.empty() ? nullptr : &itr->second;
+         }
+
+         int32_t iterator_to( table_type& t, typename std::set<std::pair<K, uint64_t>>::iterator itr, uint64_t* primary ) {
+            if( itr == t.ordered.end() )
+               return _iterators.end_iterator( t );
+            *primary = itr->second;
+            return _iterators.add( t, t.rows.at( itr->second ) );
+         }
+
+         std::map<table_key, table_type>         _tables;
+         iterator_cache<table_type, row_type>    _iterators;
+      };
+
+      struct state {
+         std::set<uint64_t>                        accounts;
+         std::map<uint64_t, apply_handler>         contracts;
+         std::map<table_key, table>                tables;
+         iterator_cache<table, row>                iterators;
+         secondary_index<uint64_t>                 idx64;
+         secondary_index<uint128_t>                idx128;
+         secondary_index<std::array<uint128_t, 2>> idx256;
+         secondary_index<double>                   idx_double;
+         secondary_index<long double>              idx_long_double;
+         std::map<uint64_t, int64_t>               ram;
+         int64_t                                   now = 0;
+         db_counters                               counters;
+         bool                                      echo = false;
+
+         context                                   ctx;
+         std::vector<std::function<void()>>*       undo = nullptr;
+
+         // notifications and inline actions sent outside of push_action are dropped
+         std::vector<uint64_t>                     direct_notified;
+         std::vector<std::pair<uint64_t, action>>  direct_inlines;
+
+         std::vector<char>                         blockchain_parameters;
+
+         state() {
+            ctx.notified = &direct_notified;
+            ctx.inlines = &direct_inlines;
+         }
+
+         table* find_table( uint64_t code, uint64_t scope, uint64_t tbl ) {
+            auto itr = tables.find( { code, scope, tbl } );
+            return itr == tables.end() || itr->second.rows.empty() ? nullptr : &itr->second;
+         }
+
+         void clear_iterators() {
+            iterators.clear();
+            idx64.clear_iterators();
+            idx128.clear_iterators();
+            idx256.clear_iterators();
+            idx_double.clear_iterators();
+            idx_long_double.clear_iterators();
+         }
+      };
+
+      state& chain() {
+         static state s;
+         return s;
+      }
+
+      void record_undo( std::function<void()> undo ) {
+         auto& s = chain();
+         if( s.undo )
+            s.undo->push_back( std::move( undo ) );
+      }
+
+      void charge( uint64_t payer, int64_t delta ) {
+         auto& s = chain();
+         if( delta > 0 && payer != s.ctx.receiver ) {
+            chain_assert( !s.ctx.in_notify(), "cannot charge RAM to other accounts during notify" );
+            if( !s.ctx.has_auth( payer ) )
+               throw assert_failure( "missing authority of " + name( payer ).to_string() );
+         }
+         s.ram[payer] += delta;
+         record_undo( [payer, delta]() { chain().ram[payer] -= delta; } );
+      }
+
+      // create the table if needed, billing it to the payer of its first row
+      template<typename Table>
+      Table& table_for_store( std::map<table_key, Table>& tables, uint64_t scope, uint64_t tbl, uint64_t payer ) {
+         chain_assert( payer != 0, "must specify a valid account to pay for new record" );
+         table_key key{ chain().ctx.receiver, scope, tbl };
+         auto& t = tables[key];
+         if( t.rows.empty() ) {
+            t.key = key;
+            t.payer = payer;
+            charge( payer, table_billable_size );
+         }
+         return t;
+      }
+
+      template<typename Table>
+      void release_if_empty( Table& t ) {
+         if( t.rows.empty() )
+            charge( t.payer, -table_billable_size );
+      }
+
+      void check_write_access( const table_key& key ) {
+         chain_assert( key.code == chain().ctx.receiver, "db access violation" );
+      }
+
+      template<typename K>
+      int32_t secondary_index<K>::store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const K& secondary ) {
+         ++chain().counters.secondary_writes;
+         validate_key( secondary );
+         auto& t = table_for_store( _tables, scope, table, payer );
+         chain_assert( !t.rows.count( id ), "could not insert object, most likely a uniqueness constraint was violated" );
+         t.put( { id, secondary, payer } );
+         charge( payer, billable_size );
+         return _iterators.add( t, t.rows.at( id ) );
+      }
+
+      template<typename K>
+      void secondary_index<K>::update( int32_t iterator, uint64_t payer, const K& secondary ) {
+         ++chain().counters.secondary_writes;
+         validate_key( secondary );
+         auto obj = _iterators.get( iterator );
+         check_write_access( obj.first->key );
+         row_type r = *obj.second;
+         if( payer == 0 )
+            payer = r.payer;
+         if( payer != r.payer ) {
+            charge( r.payer, -billable_size );
+            charge( payer, billable_size );
+         }
+         r.payer = payer;
+         r.secondary = secondary;
+         obj.first->put( r );
+      }
+
+      template<typename K>
+      void secondary_index<K>::remove( int32_t iterator ) {
+         ++chain().counters.secondary_writes;
+         auto obj = _iterators.get( iterator );
+         check_write_access( obj.first->key );
+         charge( obj.second->payer, -billable_size );
+         _iterators.remove( iterator );
+         obj.first->erase( obj.second->primary );
+         release_if_empty( *obj.first );
+      }
+
+      template<typename K>
+      int32_t secondary_index<K>::next( int32_t iterator, uint64_t* primary ) {
+         ++chain().counters.secondary_reads;
+         if( iterator < -1 )
+            return -1; // cannot increment past the end iterator
+         auto obj = _iterators.get( iterator );
+         auto itr = obj.first->ordered.find( { obj.second->secondary, obj.second->primary } );
+         return iterator_to( *obj.first, ++itr, primary );
+      }
+
+      template<typename K>
+      int32_t secondary_index<K>::previous( int32_t iterator, uint64_t* primary ) {
+         ++chain().counters.secondary_reads;
+         if( iterator < -1 ) {
+            auto& t = _iterators.end_table( iterator );
+            if( t.ordered.empty() )
+               return -1;
+            return iterator_to( t, std::prev( t.ordered.end() ), primary );
+         }
+         auto obj = _iterators.get( iterator );
+         auto itr = obj.first->ordered.find( { obj.second->secondary, obj.second->primary } );
+         if( itr == obj.first->ordered.begin() )
+            return -1;
+         return iterator_to( *obj.first, --itr, primary );
+      }
+
+      template<typename K>
+      int32_t secondary_index<K>::find_primary( uint64_t code, uint64_t scope, uint64_t table, K& secondary, uint64_t primary ) {
+         ++chain().counters.secondary_reads;
+         auto t = find_table( code, scope, table );
+         if( !t )
+            return -1;
+         auto itr = t->rows.find( primary );
+         if( itr == t->rows.end() )
+            return _iterators.end_iterator( *t );
+         secondary = itr->second.secondary;
+         return _iterators.add( *t, itr->second );
+      }
+
+      template<typename K>
+      int32_t secondary_index<K>::find_secondary( uint64_t code, uint64_t scope, uint64_t table, const K& secondary, uint64_t* primary ) {
+         ++chain().counters.secondary_reads;
+         auto t = find_table( code, scope, table );
+         if( !t )
+            return -1;
+         auto itr = t->ordered.lower_bound( { secondary, 0 } );
+         if( itr == t->ordered.end() || itr->first != secondary )
+            return _iterators.end_iterator( *t );
+         return iterator_to( *t, itr, primary );
+      }
+
+      template<typename K>
+      int32_t secondary_index<K>::lowerbound( uint64_t code, uint64_t scope, uint64_t table, K& secondary, uint64_t* primary ) {
+         ++chain().counters.secondary_reads;
+         auto t = find_table( code, scope, table );
+         if( !t )
+            return -1;
+         auto itr = t->ordered.lower_bound( { secondary, 0 } );
+         if( itr != t->ordered.end() )
+            secondary = itr->first;
+         return iterator_to( *t, itr, primary );
+      }
+
+      template<typename K>
+      int32_t secondary_index<K>::upperbound( uint64_t code, uint64_t scope, uint64_t table, K& secondary, uint64_t* primary ) {
+         ++chain().counters.secondary_reads;
+         auto t = find_table( code, scope, table );
+         if( !t )
+            return -1;
+         auto itr = t->ordered.upper_bound( { secondary, std::numeric_limits<uint64_t>::max() } );
+         if( itr != t->ordered.end() )
+            secondary = itr->first;
+         return iterator_to( *t, itr, primary );
+      }
+
+      template<typename K>
+      int32_t secondary_index<K>::end( uint64_t code, uint64_t scope, uint64_t table ) {
+         ++chain().counters.secondary_reads;
+         auto t = find_table( code, scope, table );
+         return t ? _iterators.end_iterator( *t ) : -1;
+      }
+
+      void console_append( const char* data, size_t len ) {
+         auto& s = chain();
+         s.ctx.console.append( data, len );
+         if( s.echo )
+            fwrite( data, 1, len, stdout );
+      }
+
+      void console_append( const std::string& str ) {
+         console_append( str.data(), str.size() );
+      }
+
+      std::string to_decimal( uint128_t v ) {
+         char buf[40];
+         char* p = buf + sizeof(buf);
+         do {
+            *--p = '0' + char(v % 10);
+            v /= 10;
+         } while( v );
+         return std::string( p, buf + sizeof(buf) );
+      }
+
+      void apply( uint64_t receiver, const action& act, uint64_t sender,
+                  std::vector<uint64_t>& notified, std::vector<std::pair<uint64_t, action>>& inlines,
+                  std::vector<action_trace>& traces ) {
+         auto& s = chain();
+         s.ctx = context{ receiver, &act, act.authorization, &notified, &inlines, sender, {} };
+         s.clear_iterators();
+         auto handler = s.contracts.find( receiver );
+         if( handler != s.contracts.end() && handler->second ) {
+            try {
+               handler->second( receiver, act.account.value, act.name.value );
+            } catch( const exit_signal& ) {
+            }
+         }
+         traces.push_back( { name( receiver ), act, std::move( s.ctx.console ) } );
+      }
+
+      void execute( const action& act, uint64_t sender, std::vector<action_trace>& traces, uint32_t depth ) {
+         chain_assert( depth < max_inline_action_depth, "max inline action depth reached" );
+         std::vector<uint64_t> notified{ act.account.value };
+         std::vector<std::pair<uint64_t, action>> inlines;
+         for( size_t i = 0; i < notified.size(); ++i )
+            apply( notified[i], act, sender, notified, inlines, traces );
+         for( const auto& in : inlines )
+            execute( in.second, in.first, traces, depth + 1 );
+      }
+
+      // backing store of the native build of malloc.cpp, grown like wasm linear memory
+      constexpr size_t wasm_page_size = 64 * 1024;
+      constexpr size_t max_heap_pages = size_t( 64 ) * 1024; // 4GiB of address space
+
+      char* heap_base() {
+         static char* base = static_cast<char*>( mmap( nullptr, max_heap_pages * wasm_page_size, PROT_READ | PROT_WRITE,
+                                                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 ) );
+         return base;
+      }
+
+      size_t heap_pages = 1;
+   } // namespace
+
+   void reset() {
+      auto& s = chain();
+      s.~state();
+      new ( &s ) state();
+   }
+
+   void create_account( name account ) {
+      chain().accounts.insert( account.value );
+   }
+
+   void set_contract( name account, apply_handler handler ) {
+      create_account( account );
+      chain().contracts[account.value] = std::move( handler );
+   }
+
+   void set_time( time_point t ) {
+      chain().now = t.time_since_epoch().count();
+   }
+
+   void advance_time( microseconds d ) {
+      chain().now += d.count();
+   }
+
+   time_point now() {
+      return time_point( microseconds( chain().now ) );
+   }
+
+   std::vector<action_trace> push_action( const action& act ) {
+      auto& s = chain();
+      if( s.undo )
+         throw std::logic_error( "push_action cannot be called from a contract" );
+      auto direct = std::move( s.ctx );
+      std::vector<std::function<void()>> undo;
+      std::vector<action_trace> traces;
+      s.undo = &undo;
+      try {
+         execute( act, 0, traces, 0 );
+      } catch( ... ) {
+         s.undo = nullptr;
+         s.clear_iterators();
+         for( auto itr = undo.rbegin(); itr != undo.rend(); ++itr )
+            ( *itr )();
+         s.ctx = std::move( direct );
+         throw;
+      }
+      s.undo = nullptr;
+      s.clear_iterators();
+      s.ctx = std::move( direct );
+      return traces;
+   }
+
+   void set_context( name receiver, std::vector<name> authorizers ) {
+      auto& s = chain();
+      s.ctx = context{ receiver.value, nullptr, {}, &s.direct_notified, &s.direct_inlines, 0, {} };
+      for( auto a : authorizers )
+         s.ctx.authorization.push_back( { a, "active"_n } );
+      s.clear_iterators();
+   }
+
+   int64_t ram_usage( name account ) {
+      auto& ram = chain().ram;
+      auto itr = ram.find( account.value );
+      return itr == ram.end() ? 0 : itr->second;
+   }
+
+   const db_counters& counters() {
+      return chain().counters;
+   }
+
+   void reset_counters() {
+      chain().counters = db_counters{};
+   }
+
+   void set_console_echo( bool echo ) {
+      chain().echo = echo;
+   }
+}} // namespace eosio::native
+
+using namespace eosio::native;
+using eosio::action;
+using eosio::name;
+
+extern "C" {
+   // system.h
+   void eosio_assert( uint32_t test, const char* msg ) {
+      if( !test )
+         throw assert_failure( msg );
+   }
+
+   void eosio_assert_message( uint32_t test, const char* msg, uint32_t msg_len ) {
+      if( !test )
+         throw assert_failure( std::string( msg, msg_len ) );
+   }
+
+   void eosio_assert_code( uint32_t test, uint64_t code ) {
+      if( !test )
+         throw assert_failure( "assertion failure with error code: " + std::to_string( code ) );
+   }
+
+   void eosio_exit( int32_t ) {
+      throw exit_signal{};
+   }
+
+   uint64_t current_time() {
+      return chain().now;
+   }
+
+   bool is_feature_activated( const void* ) {
+      return true;
+   }
+
+   uint64_t get_sender() {
+      return chain().ctx.sender;
+   }
+
+   // privileged.h
+   void set_blockchain_parameters_packed( char* data, uint32_t datalen ) {
+      chain().blockchain_parameters.assign( data, data + datalen );
+   }
+
+   uint32_t get_blockchain_parameters_packed( char* data, uint32_t datalen ) {
+      const auto& params = chain().blockchain_parameters;
+      if( datalen == 0 )
+         return params.size();
+      uint32_t copy_size = std::min<size_t>( datalen, params.size() );
+      memcpy( data, params.data(), copy_size );
+      return copy_size;
+   }
+
+   // there is no producer schedule, proposals are accepted and dropped
+   int64_t set_proposed_producers( char*, uint32_t ) {
+      return 0;
+   }
+
+   uint32_t get_active_producers( uint64_t*, uint32_t ) {
+      return 0;
+   }
+
+   // action.h
+   uint32_t read_action_data( void* msg, uint32_t len ) {
+      auto act = chain().ctx.act;
+      if( !act )
+         return 0;
+      if( len == 0 )
+         return act->data.size();
+      uint32_t copy_size = std::min<size_t>( len, act->data.size() );
+      memcpy( msg, act->data.data(), copy_size );
+      return copy_size;
+   }
+
+   uint32_t action_data_size() {
+      auto act = chain().ctx.act;
+      return act ? act->data.size() : 0;
+   }
+
+   void require_recipient( uint64_t recipient ) {
+      auto& notified = *chain().ctx.notified;
+      if( std::find( notified.begin(), notified.end(), recipient ) == notified.end() )
+         notified.push_back( recipient );
+   }
+
+   bool has_auth( uint64_t account ) {
+      return chain().ctx.has_auth( account );
+   }
+
+   void require_auth( uint64_t account ) {
+      if( !has_auth( account ) )
+         throw assert_failure( "missing authority of " + name( account ).to_string() );
+   }
+
+   void require_auth2( uint64_t account, uint64_t permission ) {
+      for( const auto& p : chain().ctx.authorization )
+         if( p.actor.value == account && p.permission.value == permission )
+            return;
+      throw assert_failure( "missing authority of " + name( account ).to_string() + "/" + name( permission ).to_string() );
+   }
+
+   bool is_account( uint64_t account ) {
+      return chain().accounts.count( account );
+   }
+
+   void send_inline( char* serialized_action, size_t size ) {
+      auto& ctx = chain().ctx;
+      auto act = eosio::unpack<action>( serialized_action, size );
+      // the receiver can always authorize with its own eosio.code permission
+      for( const auto& p : act.authorization )
+         if( p.actor.value != ctx.receiver && !ctx.has_auth( p.actor.value ) )
+            throw assert_failure( "missing authority of " + p.actor.to_string() );
+      ctx.inlines->emplace_back( ctx.receiver, std::move( act ) );
+   }
+
+   void send_context_free_inline( char* serialized_action, size_t size ) {
+      send_inline( serialized_action, size );
+   }
+
+   uint64_t publication_time() {
+      return chain().now;
+   }
+
+   uint64_t current_receiver() {
+      return chain().ctx.receiver;
+   }
+
+   // print.h
+   void prints( const char* cstr ) {
+      console_append( cstr, strlen( cstr ) );
+   }
+
+   void prints_l( const char* cstr, uint32_t len ) {
+      console_append( cstr, len );
+   }
+
+   void printi( int64_t value ) {
+      console_append( std::to_string( value ) );
+   }
+
+   void printui( uint64_t value ) {
+      console_append( std::to_string( value ) );
+   }
+
+   void printi128( const int128_t* value ) {
+      int128_t v = *value;
+      console_append( v < 0 ? "-" + to_decimal( -uint128_t( v ) ) : to_decimal( v ) );
+   }
+
+   void printui128( const uint128_t* value ) {
+      console_append( to_decimal( *value ) );
+   }
+
+   void printsf( float value ) {
+      char buf[64];
+      console_append( buf, snprintf( buf, sizeof(buf), "%.*e", std::numeric_limits<float>::digits10, value ) );
+   }
+
+   void printdf( double value ) {
+      char buf[64];
+      console_append( buf, snprintf( buf, sizeof(buf), "%.*e", std::numeric_limits<double>::digits10, value ) );
+   }
+
+   void printqf( const long double* value ) {
+      char buf[96];
+      console_append( buf, snprintf( buf, sizeof(buf), "%.*Le", std::numeric_limits<long double>::digits10, *value ) );
+   }
+
+   void printn( uint64_t value ) {
+      console_append( name( value ).to_string() );
+   }
+
+   void printhex( const void* data, uint32_t datalen ) {
+      static const char digits[] = "0123456789abcdef";
+      std::string out;
+      out.reserve( datalen * 2 );
+      for( uint32_t i = 0; i < datalen; ++i ) {
+         uint8_t b = static_cast<const uint8_t*>( data )[i];
+         out += digits[b >> 4];
+         out += digits[b & 0xf];
+      }
+      console_append( out );
+   }
+
+   // db.h, primary index
+   int32_t db_store_i64( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const void* data, uint32_t len ) {
+      auto& s = chain();
+      ++s.counters.primary_writes;
+      auto& t = table_for_store( s.tables, scope, table, payer );
+      chain_assert( !t.rows.count( id ), "could not insert object, most likely a uniqueness constraint was violated" );
+      const char* begin = static_cast<const char*>( data );
+      t.put( { id, payer, std::vector<char>( begin, begin + len ) } );
+      charge( payer, len + row_billable_size );
+      return s.iterators.add( t, t.rows.at( id ) );
+   }
+
+   void db_update_i64( int32_t iterator, uint64_t payer, const void* data, uint32_t len ) {
+      auto& s = chain();
+      ++s.counters.primary_writes;
+      auto obj = s.iterators.get( iterator );
+      check_write_access( obj.first->key );
+      const row& old = *obj.second;
+      int64_t old_size = old.value.size() + row_billable_size;
+      int64_t new_size = len + row_billable_size;
+      if( payer == 0 )
+         payer = old.payer;
+      if( payer != old.payer ) {
+         charge( old.payer, -old_size );
+         charge( payer, new_size );
+      } else if( old_size != new_size ) {
+         charge( payer, new_size - old_size );
+      }
+      const char* begin = static_cast<const char*>( data );
+      obj.first->put( { old.primary, payer, std::vector<char>( begin, begin + len ) } );
+   }
+
+   void db_remove_i64( int32_t iterator ) {
+      auto& s = chain();
+      ++s.counters.primary_writes;
+      auto obj = s.iterators.get( iterator );
+      check_write_access( obj.first->key );
+      charge( obj.second->payer, -int64_t( obj.second->value.size() + row_billable_size ) );
+      s.iterators.remove( iterator );
+      obj.first->erase( obj.second->primary );
+      release_if_empty( *obj.first );
+   }
+
+   int32_t db_get_i64( int32_t iterator, void* data, uint32_t len ) {
+      auto& s = chain();
+      ++s.counters.primary_reads;
+      const auto& value = s.iterators.get( iterator ).second->value;
+      if( len == 0 )
+         return value.size();
+      uint32_t copy_size = std::min<size_t>( len, value.size() );
+      memcpy( data, value.data(), copy_size );
+      return copy_size;
+   }
+
+   int32_t db_next_i64( int32_t iterator, uint64_t* primary ) {
+      auto& s = chain();
+      ++s.counters.primary_reads;
+      if( iterator < -1 )
+         return -1; // cannot increment past the end iterator
+      auto obj = s.iterators.get( iterator );
+      auto itr = obj.first->rows.upper_bound( obj.second->primary );
+      if( itr == obj.first->rows.end() )
+         return s.iterators.end_iterator( *obj.first );
+      *primary = itr->first;
+      return s.iterators.add( *obj.first, itr->second );
+   }
+
+   int32_t db_previous_i64( int32_t iterator, uint64_t* primary ) {
+      auto& s = chain();
+      ++s.counters.primary_reads;
+      table* t;
+      std::map<uint64_t, row>::iterator itr;
+      if( iterator < -1 ) {
+         t = &s.iterators.end_table( iterator );
+         itr = t->rows.end();
+      } else {
+         auto obj = s.iterators.get( iterator );
+         t = obj.first;
+         itr = t->rows.find( obj.second->primary );
+      }
+      if( itr == t->rows.begin() )
+         return -1;
+      --itr;
+      *primary = itr->first;
+      return s.iterators.add( *t, itr->second );
+   }
+
+   int32_t db_find_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+      auto& s = chain();
+      ++s.counters.primary_reads;
+      auto t = s.find_table( code, scope, table );
+      if( !t )
+         return -1;
+      auto itr = t->rows.find( id );
+      if( itr == t->rows.end() )
+         return s.iterators.end_iterator( *t );
+      return s.iterators.add( *t, itr->second );
+   }
+
+   int32_t db_lowerbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+      auto& s = chain();
+      ++s.counters.primary_reads;
+      auto t = s.find_table( code, scope, table );
+      if( !t )
+         return -1;
+      auto itr = t->rows.lower_bound( id );
+      if( itr == t->rows.end() )
+         return s.iterators.end_iterator( *t );
+      return s.iterators.add( *t, itr->second );
+   }
+
+   int32_t db_upperbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+      auto& s = chain();
+      ++s.counters.primary_reads;
+      auto t = s.find_table( code, scope, table );
+      if( !t )
+         return -1;
+      auto itr = t->rows.upper_bound( id );
+      if( itr == t->rows.end() )
+         return s.iterators.end_iterator( *t );
+      return s.iterators.add( *t, itr->second );
+   }
+
+   int32_t db_end_i64( uint64_t code, uint64_t scope, uint64_t table ) {
+      auto& s = chain();
+      ++s.counters.primary_reads;
+      auto t = s.find_table( code, scope, table );
+      return t ? s.iterators.end_iterator( *t ) : -1;
+   }
+
+   // db.h, secondary indices
+#define NATIVE_SECONDARY_INDEX( IDX, TYPE )                                                                            \
+   int32_t db_##IDX##_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const TYPE* secondary ) {      \
+      return chain().IDX.store( scope, table, payer, id, *secondary );                                                 \
+   }                                                                                                                   \
+   void db_##IDX##_update( int32_t iterator, uint64_t payer, const TYPE* secondary ) {                                 \
+      chain().IDX.update( iterator, payer, *secondary );                                                               \
+   }                                                                                                                   \
+   void db_##IDX##_remove( int32_t iterator ) {                                                                        \
+      chain().IDX.remove( iterator );                                                                                  \
+   }                                                                                                                   \
+   int32_t db_##IDX##_next( int32_t iterator, uint64_t* primary ) {                                                    \
+      return chain().IDX.next( iterator, primary );                                                                    \
+   }                                                                                                                   \
+   int32_t db_##IDX##_previous( int32_t iterator, uint64_t* primary ) {                                                \
+      return chain().IDX.previous( iterator, primary );                                                                \
+   }                                                                                                                   \
+   int32_t db_##IDX##_find_primary( uint64_t code, uint64_t scope, uint64_t table, TYPE* secondary, uint64_t primary ) { \
+      return chain().IDX.find_primary( code, scope, table, *secondary, primary );                                      \
+   }                                                                                                                   \
+   int32_t db_##IDX##_find_secondary( uint64_t code, uint64_t scope, uint64_t table, const TYPE* secondary,            \
+                                      uint64_t* primary ) {                                                            \
+      return chain().IDX.find_secondary( code, scope, table, *secondary, primary );                                    \
+   }                                                                                                                   \
+   int32_t db_##IDX##_lowerbound( uint64_t code, uint64_t scope, uint64_t table, TYPE* secondary, uint64_t* primary ) { \
+      return chain().IDX.lowerbound( code, scope, table, *secondary, primary );                                        \
+   }                                                                                                                   \
+   int32_t db_##IDX##_upperbound( uint64_t code, uint64_t scope, uint64_t table, TYPE* secondary, uint64_t* primary ) { \
+      return chain().IDX.upperbound( code, scope, table, *secondary, primary );                                        \
+   }                                                                                                                   \
+   int32_t db_##IDX##_end( uint64_t code, uint64_t scope, uint64_t table ) {                                           \
+      return chain().IDX.end( code, scope, table );                                                                    \
+   }
+
+   NATIVE_SECONDARY_INDEX( idx64, uint64_t )
+   NATIVE_SECONDARY_INDEX( idx128, uint128_t )
+   NATIVE_SECONDARY_INDEX( idx_double, double )
+   NATIVE_SECONDARY_INDEX( idx_long_double, long double )
+
+#undef NATIVE_SECONDARY_INDEX
+
+   // idx256 keys are passed as arrays of two 128-bit words
+   using key256 = std::array<uint128_t, 2>;
+
+   static key256 to_key256( const uint128_t* data, uint32_t data_len ) {
+      chain_assert( data_len == 2, "invalid size of secondary key array for idx256" );
+      return { data[0], data[1] };
+   }
+
+   int32_t db_idx256_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const uint128_t* data, uint32_t data_len ) {
+      return chain().idx256.store( scope, table, payer, id, to_key256( data, data_len ) );
+   }
+
+   void db_idx256_update( int32_t iterator, uint64_t payer, const uint128_t* data, uint32_t data_len ) {
+      chain().idx256.update( iterator, payer, to_key256( data, data_len ) );
+   }
+
+   void db_idx256_remove( int32_t iterator ) {
+      chain().idx256.remove( iterator );
+   }
+
+   int32_t db_idx256_next( int32_t iterator, uint64_t* primary ) {
+      return chain().idx256.next( iterator, primary );
+   }
+
+   int32_t db_idx256_previous( int32_t iterator, uint64_t* primary ) {
+      return chain().idx256.previous( iterator, primary );
+   }
+
+   int32_t db_idx256_find_primary( uint64_t code, uint64_t scope, uint64_t table, uint128_t* data, uint32_t data_len, uint64_t primary ) {
+      auto key = to_key256( data, data_len );
+      auto itr = chain().idx256.find_primary( code, scope, table, key, primary );
+      data[0] = key[0];
+      data[1] = key[1];
+      return itr;
+   }
+
+   int32_t db_idx256_find_secondary( uint64_t code, uint64_t scope, uint64_t table, const uint128_t* data, uint32_t data_len, uint64_t* primary ) {
+      return chain().idx256.find_secondary( code, scope, table, to_key256( data, data_len ), primary );
+   }
+
+   int32_t db_idx256_lowerbound( uint64_t code, uint64_t scope, uint64_t table, uint128_t* data, uint32_t data_len, uint64_t* primary ) {
+      auto key = to_key256( data, data_len );
+      auto itr = chain().idx256.lowerbound( code, scope, table, key, primary );
+      data[0] = key[0];
+      data[1] = key[1];
+      return itr;
+   }
+
+   int32_t db_idx256_upperbound( uint64_t code, uint64_t scope, uint64_t table, uint128_t* data, uint32_t data_len, uint64_t* primary ) {
+      auto key = to_key256( data, data_len );
+      auto itr = chain().idx256.upperbound( code, scope, table, key, primary );
+      data[0] = key[0];
+      data[1] = key[1];
+      return itr;
+   }
+
+   int32_t db_idx256_end( uint64_t code, uint64_t scope, uint64_t table ) {
+      return chain().idx256.end( code, scope, table );
+   }
+
+   // linear memory of the native build of malloc.cpp
+   uintptr_t __get_heap_base() {
+      return reinterpret_cast<uintptr_t>( heap_base() );
+   }
+
+   size_t _current_memory() {
+      return heap_pages;
+   }
+
+   size_t _grow_memory( size_t pages ) {
+      if( heap_base() == MAP_FAILED || pages > max_heap_pages - heap_pages )
+         return size_t( -1 );
+      size_t prev = heap_pages;
+      heap_pages += pages;
+      return prev;
+   }
+}
@@ -0,0 +1,111 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#pragma once
+#include "../../contracts/eosio/action.hpp"
+#include "../../core/eosio/name.hpp"
+#include "../../core/eosio/time.hpp"
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace eosio {
+
+   /**
+    * @defgroup native Native
+    * @ingroup contracts
+    * @brief In-process emulation of the chain intrinsics for native builds
+    * @details Linking `native_eosio` into a native executable provides the
+    * database, action, print and system intrinsics, backed by ordered
+    * in-memory maps. A driver registers the `apply` handler of each contract,
+    * pushes actions and inspects the resulting state, RAM usage and console
+    * output, which lets contracts be benchmarked and regression tested
+    * without a node.
+    *
+    * @code
+    * native::create_account("alice"_n);
+    * native::set_contract("cryptoart"_n, apply);
+    * native::set_time(time_point_sec(1600000000));
+    * native::push_action(action({"alice"_n, "active"_n}, "cryptoart"_n,
+    *                            "transfer"_n, std::make_tuple(...)));
+    * @endcode
+    * @{
+    */
+   namespace native {
+
+      /**
+       * Thrown by `eosio_assert` and friends when a check fails. Pushing an
+       * action rolls back every change made by the transaction before
+       * rethrowing it.
+       */
+      struct assert_failure : std::runtime_error {
+         using std::runtime_error::runtime_error;
+      };
+
+      /// Handler with the signature of a contract's `apply` entry point
+      using apply_handler = std::function<void(uint64_t receiver, uint64_t code, uint64_t action)>;
+
+      /// One executed action, including notifications and inline actions
+      struct action_trace {
+         name        receiver;
+         action      act;
+         std::string console;
+      };
+
+      /// Number of database intrinsics called since the last reset_counters()
+      struct db_counters {
+         uint64_t primary_reads    = 0; ///< find, lowerbound, upperbound, end, get, next and previous
+         uint64_t primary_writes   = 0; ///< store, update and remove
+         uint64_t secondary_reads  = 0; ///< index lookups and iteration
+         uint64_t secondary_writes = 0; ///< index store, update and remove
+      };
+
+      /// Drop every account, contract, row and counter and reset the clock
+      void reset();
+
+      /// Create an account so that `is_account` succeeds for it
+      void create_account( name account );
+
+      /// Create `account` if needed and dispatch its actions and notifications to `handler`
+      void set_contract( name account, apply_handler handler );
+
+      /// Set the time returned by `current_time` and `publication_time`
+      void set_time( time_point t );
+
+      /// Move the clock forward
+      void advance_time( microseconds d );
+
+      time_point now();
+
+      /**
+       * Execute `act` as a single-action transaction: the receiver and every
+       * notified contract are applied, followed by the inline actions they
+       * sent. On failure all changes are rolled back and the assert_failure
+       * is rethrown.
+       *
+       * @return traces of the executed actions, in execution order
+       */
+      std::vector<action_trace> push_action( const action& act );
+
+      /**
+       * Call contract code directly, outside of push_action, as if it ran in
+       * an action of `receiver` authorized by `authorizers`. Changes made in
+       * this mode are not rolled back on failure.
+       */
+      void set_context( name receiver, std::vector<name> authorizers = {} );
+
+      /// Bytes of RAM billed to `account`, with the chain's per-row overheads
+      int64_t ram_usage( name account );
+
+      const db_counters& counters();
+
+      void reset_counters();
+
+      /// Also write the console output of actions to stdout
+      void set_console_echo( bool echo );
+   }
+   /// @}
+}
@@ -13,7 +13,9 @@
 #define GROW_MEMORY(X) __builtin_wasm_grow_memory(X)
 #endif
 
-namespace eosio {   
+extern "C" void* memcpy(void*, const void*, size_t);
+
+namespace eosio {
    struct dsmalloc {
       inline char* align(char* ptr, uint8_t align_amt) {
          return (char*)((((size_t)ptr) + align_amt-1) & ~(align_amt-1));
@@ -25,36 +27,72 @@ namespace eosio {
 
       static constexpr uint32_t wasm_page_size = 64*1024;
 
-      dsmalloc() {
+      // globals are only zero initialized in wasm, so set up on first use instead of in a constructor
+      void init() {
          volatile uintptr_t heap_base = 0; // linker places this at address 0
          heap = align(*(char**)heap_base, 8);
          last_ptr = heap;
+         last_alloc = nullptr;
 
          next_page = CURRENT_MEMORY;
       }
-       
+
       char* operator()(size_t sz, uint8_t align_amt=8) {
          if (sz == 0)
             return NULL;
+         if (heap == nullptr)
+            init();
+
+         char* ret = align(last_ptr, align_amt);
+         bump(ret, sz);
+         return ret;
+      }
 
-         char* ret = last_ptr;
-         last_ptr = align(last_ptr+sz, align_amt);
+      // the most recent allocation can grow or shrink in place; any other block is copied into a new one
+      char* realloc(char* ptr, size_t sz) {
+         if (ptr == last_alloc) {
+            bump(ptr, sz);
+            return ptr;
+         }
 
-         size_t pages_to_alloc = sz >> 16;
-         next_page += pages_to_alloc;
-         if ((next_page << 16) <= (size_t)last_ptr) {
-            next_page++;
-            pages_to_alloc++;
-         }         
-         eosio::check(GROW_MEMORY(pages_to_alloc) != -1, "failed to allocate pages");  
+         char* ret = (*this)(sz);
+         // the old block ends before the tail, so this never reads past committed memory
+         const size_t available = ret - ptr;
+         memcpy(ret, ptr, sz < available ? sz : available);
          return ret;
       }
 
+      // only the most recent allocation can be given back
+      void free(char* ptr) {
+         if (ptr != last_alloc)
+            return;
+         last_ptr = ptr;
+         last_alloc = nullptr;
+      }
+
+      void reset(char* mark) {
+         eosio::check(mark >= heap && mark <= last_ptr, "invalid arena mark");
+         last_ptr = mark;
+         last_alloc = nullptr;
+      }
+
+      void bump(char* ptr, size_t sz) {
+         last_alloc = ptr;
+         last_ptr = align(ptr+sz, 8);
+
+         const size_t end = (size_t)last_ptr;
+         if (end > next_page * wasm_page_size) {
+            const size_t pages_to_alloc = (end - next_page * wasm_page_size + wasm_page_size - 1) / wasm_page_size;
+            eosio::check(GROW_MEMORY(pages_to_alloc) != -1, "failed to allocate pages");
+            next_page += pages_to_alloc;
+         }
+      }
+
       char*  heap;
       char*  last_ptr;
-      size_t offset;
+      char*  last_alloc;
       size_t next_page;
-   }; 
+   };
    dsmalloc _dsmalloc;
 } // ns eosio
 
@@ -67,6 +105,8 @@ void* malloc(size_t size) {
 
 void* memset(void*,int,size_t);
 void* calloc(size_t count, size_t size) {
+   if (size != 0 && count > size_t(-1) / size)
+      return nullptr;
    if (void* ptr = eosio::_dsmalloc(count*size)) {
       memset(ptr, 0, count*size);
       return ptr;
@@ -75,9 +115,26 @@ void* calloc(size_t count, size_t size) {
 }
 
 void* realloc(void* ptr, size_t size) {
-   return eosio::_dsmalloc(size);
+   if (ptr == nullptr)
+      return eosio::_dsmalloc(size);
+   if (size == 0) {
+      eosio::_dsmalloc.free(static_cast<char*>(ptr));
+      return nullptr;
+   }
+   return eosio::_dsmalloc.realloc(static_cast<char*>(ptr), size);
 }
 
-void free(void* ptr) {}
+void free(void* ptr) {
+   eosio::_dsmalloc.free(static_cast<char*>(ptr));
 }
 
+void* eosio_dsm_mark() {
+   if (eosio::_dsmalloc.heap == nullptr)
+      eosio::_dsmalloc.init();
+   return eosio::_dsmalloc.last_ptr;
+}
+
+void eosio_dsm_reset(void* mark) {
+   eosio::_dsmalloc.reset(static_cast<char*>(mark));
+}
+}
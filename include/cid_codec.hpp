@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Binary storage of IPFS content ids.
+ *
+ * A CIDv0 is the base58btc encoding of a sha2-256 multihash: the hash function
+ * code 0x12, the digest length 0x20 and the 32 byte digest. Tokens store those
+ * 34 bytes instead of the 46 character string.
+ */
+namespace cid_codec {
+
+constexpr size_t multihash_size = 34;
+
+inline const char *alphabet() {
+  return "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+}
+
+inline int digit(char c) {
+  const char *a = alphabet();
+  for (int i = 0; i < 58; i++) {
+    if (a[i] == c) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+inline std::string encode(const std::vector<char> &bytes) {
+  // base 256 to base 58, most significant digit last
+  std::vector<uint8_t> digits;
+  digits.reserve(bytes.size() * 138 / 100 + 1);
+  size_t zeros = 0;
+  while (zeros < bytes.size() && bytes[zeros] == 0) {
+    zeros++;
+  }
+  for (size_t i = zeros; i < bytes.size(); i++) {
+    uint32_t carry = uint8_t(bytes[i]);
+    for (auto &d : digits) {
+      carry += uint32_t(d) << 8;
+      d = carry % 58;
+      carry /= 58;
+    }
+    while (carry) {
+      digits.push_back(carry % 58);
+      carry /= 58;
+    }
+  }
+  std::string out(zeros, '1');
+  out.reserve(zeros + digits.size());
+  for (auto it = digits.rbegin(); it != digits.rend(); it++) {
+    out.push_back(alphabet()[*it]);
+  }
+  return out;
+}
+
+// Decode `text` into `out`, false if it is not valid base58.
+inline bool decode(const std::string &text, std::vector<char> &out) {
+  // base 58 to base 256, most significant byte last
+  std::vector<uint8_t> bytes;
+  bytes.reserve(text.size() * 733 / 1000 + 1);
+  size_t zeros = 0;
+  while (zeros < text.size() && text[zeros] == '1') {
+    zeros++;
+  }
+  for (size_t i = zeros; i < text.size(); i++) {
+    int d = digit(text[i]);
+    if (d < 0) {
+      return false;
+    }
+    uint32_t carry = d;
+    for (auto &b : bytes) {
+      carry += uint32_t(b) * 58;
+      b = carry & 0xff;
+      carry >>= 8;
+    }
+    while (carry) {
+      bytes.push_back(carry & 0xff);
+      carry >>= 8;
+    }
+  }
+  out.assign(zeros, 0);
+  out.insert(out.end(), bytes.rbegin(), bytes.rend());
+  return true;
+}
+
+// Multihash of a CIDv0 string, empty if `cid` is anything else.
+inline std::vector<char> to_multihash(const std::string &cid) {
+  std::vector<char> out;
+  if (!decode(cid, out) || out.size() != multihash_size ||
+      uint8_t(out[0]) != 0x12 || uint8_t(out[1]) != 0x20) {
+    return {};
+  }
+  // only canonical encodings, so the stored bytes give back `cid`
+  if (encode(out) != cid) {
+    return {};
+  }
+  return out;
+}
+
+} // namespace cid_codec
@@ -1,11 +1,18 @@
 #include <eosio/asset.hpp>
+#include <eosio/binary_extension.hpp>
 #include <eosio/crypto.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/print.hpp>
+#include <eosio/singleton.hpp>
 #include <eosio/system.hpp>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "cid_codec.hpp"
+#include "lever_codec.hpp"
+
 using namespace eosio;
 using namespace std;
 typedef uint128_t global_id;
@@ -22,7 +29,9 @@ public:
   using contract::contract;
   cryptoart(name receiver, name code, datastream<const char *> ds)
       : contract(receiver, code, ds), tokens(receiver, receiver.value),
-        control_tokens(receiver, receiver.value) {}
+        control_tokens(receiver, receiver.value),
+        control_values(receiver, receiver.value),
+        lever_schemas(receiver, receiver.value) {}
 
   /**
    * Create a new non-fungible token.
@@ -44,6 +53,19 @@ public:
    */
   ACTION transfer(name from, name to, id_type token_id, string memo);
 
+  /**
+   * Transfer multiple nfts from `from` in one action. Token `token_ids[i]`
+   * goes to `recipients[i]`. Balance changes are grouped per (owner, symbol)
+   * so each account row is written once for the whole batch.
+   *
+   * @param from - Account name of tokens owner
+   * @param token_ids - Unique IDs of the tokens to transfer
+   * @param recipients - Receiver of each token
+   * @param memo - Action memo. Maximum 256 bytes
+   */
+  ACTION transferbatch(name from, vector<id_type> token_ids,
+                       vector<name> recipients, string memo);
+
   /**
    * Burn 1 token with specified `id` owner by account `owner`.
    * Only tokens of this world can be burnt.
@@ -61,13 +83,18 @@ public:
    * @param min_values - Minimum values list with index as lever_id
    * @param max_values - Maximum values list with index as lever_id
    * @param curr_values - Current values list with indnex as lever_id
+   * @param lever_widths - Optional storage width of each lever: 1, 2, 4 or 8
+   * bytes, or 0 for zigzag varint. Narrowest fixed width fitting the bounds
+   * is used if omitted
    */
   ACTION setuptoken(id_type token_id, vector<int64_t> min_values,
-                    vector<int64_t> max_values, vector<int64_t> curr_values);
+                    vector<int64_t> max_values, vector<int64_t> curr_values,
+                    binary_extension<vector<uint8_t>> lever_widths);
 
   /**
    * Mint master layer of art work to `to` and multiple layer tokens to
-   * given collaborators.
+   * given collaborators. Layer tokens take the ids following the master.
+   * With `CRYPTOART_LAYER_KEYS` the master id is `token_id << 16`.
    * @param token_id - Available master token id.
    * @param to - Target artist holding the master layer
    * @param uri - URI for master layer. e.g. url of image
@@ -117,8 +144,91 @@ public:
    */
   ACTION auctionend(id_type token_id);
 
-  ACTION clearauction();
-  ACTION cleartokens();
+  /**
+   * Settle up to `max_count` expired open auctions, earliest end time first.
+   * Each settlement closes the auction, pays the token owner and transfers
+   * the token to the top bidder. Can be called by anyone.
+   * @param max_count - Maximum number of auctions to settle
+   */
+  ACTION settleexpired(uint64_t max_count);
+
+  /**
+   * Store the `byexpiry` index entry of auctions created before the index
+   * existed. Must run after upgrading, before those auctions are modified.
+   * Rows are not rewritten and keep their RAM payer, the contract pays for
+   * the index entries.
+   * @param from_id - Auction token id to start from
+   * @param max_rows - Maximum number of auction rows to visit
+   */
+  ACTION migrateauct(id_type from_id, uint64_t max_rows);
+
+  /**
+   * Move legacy current values stored in `ctltokens` rows into `ctlvalues`.
+   * Rows are also migrated lazily on their first `updatetoken`.
+   * @param from_id - Control token id to start migrating from
+   * @param max_rows - Maximum number of control token rows to visit
+   */
+  ACTION migratevals(id_type from_id, uint64_t max_rows);
+
+  /**
+   * Erase up to `max_rows` rows of the auction table, together with the
+   * bid qualification of each auction's bidder. Progress is kept in the
+   * `clrauction` singleton so repeated calls resume where the last stopped.
+   * @param max_rows - Maximum number of rows to erase in this call
+   */
+  ACTION clearauction(uint64_t max_rows);
+
+  /**
+   * Erase up to `max_rows` rows of the `ctltokens`, `ctlvalues`,
+   * `leverschemas`, `tokens` and `stats` tables in that order, together with the balance row of each
+   * token owner. Entries left in the former `tokens` indexes are freed
+   * before `stats`, one index per call, the printed id being the slot. Progress is kept in the `clrtokens` singleton so repeated
+   * calls resume where the last stopped.
+   * @param max_rows - Maximum number of rows to erase in this call
+   */
+  ACTION cleartokens(uint64_t max_rows);
+
+  /**
+   * Erase the balance and bid qualification rows in the given scopes, e.g.
+   * the ones left after `cleartokens`/`clearauction` as listed by the
+   * `get_table_by_scope` API.
+   * @param scopes - Accounts whose rows to erase
+   */
+  ACTION clearscopes(vector<name> scopes);
+
+  /**
+   * Shrink the `uri` of tokens minted before CIDs were stored in binary.
+   * Master tokens of CIDv0 uris keep only the multihash, layer tokens keep
+   * nothing. Other uris are left as they are.
+   * @param from_id - Token id to start migrating from
+   * @param max_rows - Maximum number of token rows to visit
+   */
+  ACTION migrateuris(id_type from_id, uint64_t max_rows);
+
+  /**
+   * Remove up to `max_entries` entries of the former `byuuid` index of the
+   * `tokens` table. Uuids are now derived from primary keys, see
+   * `find_by_uuid`. Call until it prints "done".
+   * @param max_entries - Maximum number of index entries to remove
+   */
+  ACTION dropuuidx(uint64_t max_entries);
+
+  /**
+   * Store the `byownersym` index entry of tokens minted before the index
+   * existed, then remove the entries of the former `byowner` and `bysymbol`
+   * indexes. Tokens transferred in the meantime are indexed on the way,
+   * until then `get_owner_tokens` misses them. Call again with the last
+   * printed id until it prints "done".
+   * @param from_id - Token id to start from
+   * @param max_rows - Maximum number of token rows or index entries to visit
+   */
+  ACTION migratetidx(id_type from_id, uint64_t max_rows);
+
+  /**
+   * Print the full uri of a token, see `get_token_uri`.
+   * @param token_id - Token unique id
+   */
+  ACTION geturi(id_type token_id);
 
   /**
    * Accept the final bid and sell token.
@@ -143,17 +253,54 @@ public:
   }
 
   /**
-   * Get layer token ids with a given master id.
+   * Get layer token ids with a given master id, the master included.
+   * With `CRYPTOART_LAYER_KEYS` layer ids follow the master id and only the
+   * master row is read, otherwise only `bymasterid` index keys are read.
    */
   vector<id_type> get_layer_tokens(id_type master_id) {
+#ifdef CRYPTOART_LAYER_KEYS
+    auto master = control_tokens.find(master_id);
+    if (master == control_tokens.end() ||
+        master->master_token_id != master_id) {
+      return {};
+    }
+    vector<id_type> ids(master->layers_num.value_or() + 1);
+    for (size_t i = 0; i < ids.size(); i++) {
+      ids[i] = master_id + i;
+    }
+    return ids;
+#else
     auto master_index = control_tokens.get_index<"bymasterid"_n>();
-    auto itr = master_index.lower_bound(master_id);
-    vector<id_type> layer_tokens;
-    while (itr != master_index.end()) {
-      layer_tokens.push_back(itr->id);
-      itr++;
+    return master_index.primary_keys(master_id, master_id);
+#endif
+  }
+
+  /**
+   * Get full uri of a token. Rows holding a uri return it as is, otherwise
+   * it is rebuilt from the CID of master tokens or the master id of layer
+   * tokens.
+   */
+  string get_token_uri(id_type token_id);
+
+  /**
+   * Find a token by global id. Its low 64 bits are the token id, its high
+   * 64 bits must be this contract.
+   */
+  auto find_by_uuid(global_id uuid) {
+    if (uint64_t(uuid >> 64) != get_self().value) {
+      return tokens.end();
     }
-    return layer_tokens;
+    return tokens.find(uint64_t(uuid));
+  }
+
+  /**
+   * Get ids of the tokens of `sym` held by `owner`.
+   * Only index keys are read, token rows are not loaded.
+   */
+  vector<id_type> get_owner_tokens(name owner, symbol_code sym) {
+    auto owner_index = tokens.get_index<"byownersym"_n>();
+    auto key = owner_symbol_key(owner, sym);
+    return owner_index.primary_keys(key, key);
   }
 
   name get_issuer(symbol_code sym) {
@@ -163,13 +310,13 @@ public:
     return info.issuer;
   }
 
+  /**
+   * Get owner of a token, or an empty name if it does not exist.
+   * Only the row prefix up to `owner` is decoded, the uri is skipped.
+   */
   name get_owner_by_id(id_type token_id) {
-    auto it = tokens.find(token_id);
-    if (it == tokens.end()) {
-      return name{};
-    } else {
-      return it->owner;
-    }
+    auto fields = tokens.get_fields<token::owner_field>(token_id);
+    return fields ? std::get<0>(*fields) : name{};
   }
 
   TABLE account {
@@ -177,6 +324,10 @@ public:
     // You can add more fields here...
 
     uint64_t primary_key() const { return balance.symbol.code().raw(); }
+
+    // fields listed so that rows are sized at compile time, new fields must
+    // be listed too
+    EOSLIB_SERIALIZE(account, (balance))
   };
 
   TABLE bid_qualification {
@@ -184,6 +335,8 @@ public:
     uint64_t avail_bid_time; // available bid time
 
     uint64_t primary_key() const { return owner.value; }
+
+    EOSLIB_SERIALIZE(bid_qualification, (owner)(avail_bid_time))
   };
 
   TABLE stat {
@@ -198,6 +351,8 @@ public:
 
     uint64_t primary_key() const { return supply.symbol.code().raw(); }
     uint64_t get_issuer() const { return issuer.value; }
+
+    EOSLIB_SERIALIZE(stat, (issuer)(supply)(issued)(max_supply)(infinite))
   };
 
   // nft definition. YOU CAN ONLY ADD FIELDS.
@@ -210,6 +365,12 @@ public:
     asset value;    // token value (e.g. 1 EOS).
 
     /* === You can add more fields below === */
+    // sha2-256 multihash of the master token CID, stored with an empty `uri`.
+    // Empty in layer tokens, whose uri is derived from their master id
+    binary_extension<vector<char>> cid;
+
+    // position of `owner` for projected reads
+    static constexpr size_t owner_field = 3;
 
     id_type primary_key() const { return id; }
     global_id get_uuid() const { return uuid; }
@@ -217,6 +378,9 @@ public:
     string get_uri() const { return uri; }
     asset get_value() const { return value; }
     uint64_t get_symbol() const { return value.symbol.code().raw(); }
+    uint128_t get_owner_symbol() const {
+      return owner_symbol_key(owner, value.symbol.code());
+    }
   };
 
   TABLE controltoken {
@@ -229,15 +393,87 @@ public:
     // master token id of the layer token
     // if it's master token, equal to the token id
     id_type master_token_id;
-    // lever values
+    // lever bounds of tokens setup before packing, immutable after setup
     vector<int64_t> min_values;
     vector<int64_t> max_values;
+    // legacy current values, moved to `ctlvalues` and empty once migrated
     vector<int64_t> curr_values;
+    // storage width of each lever, see `lever_codec`
+    binary_extension<vector<uint8_t>> lever_widths;
+    // packed (min, max) bounds of each lever
+    binary_extension<vector<char>> packed_bounds;
+    // owner of the token, kept in sync with `tokens`. Empty in rows written
+    // before it was added, until the token changes hands
+    binary_extension<name> owner;
+    // number of layer tokens of a master token, 0 in layer tokens
+    binary_extension<uint64_t> layers_num;
+    // `leverschemas` row holding the widths and bounds, 0 in tokens set up
+    // before schemas were shared, which keep them in this row
+    binary_extension<uint64_t> schema_id;
 
     id_type primary_key() const { return id; }
     id_type get_master_id() const { return master_token_id; }
   };
 
+  // billed to the first owner setting it up, shared by later tokens for free
+  TABLE leverschema {
+    // low 64 bits of `hash`, probed upwards on collision, never 0
+    uint64_t id;
+    // sha256 of the packed (lever_widths, packed_bounds) pair
+    checksum256 hash;
+    // storage width of each lever, see `lever_codec`
+    vector<uint8_t> lever_widths;
+    // packed (min, max) bounds of each lever
+    vector<char> packed_bounds;
+
+    uint64_t primary_key() const { return id; }
+  };
+
+  // lever widths and bounds of a set up token, held by its schema or, for
+  // older tokens, by its own row
+  struct lever_layout {
+    const controltoken &token;
+    // null for tokens set up before values were packed
+    const vector<uint8_t> *widths;
+    const vector<char> *packed_bounds;
+
+    bool is_packed() const { return widths != nullptr && !widths->empty(); }
+    int64_t min_at(size_t lever) const {
+      return is_packed()
+                 ? lever_codec::unpack(*widths, *packed_bounds, lever, 2, 0)
+                 : token.min_values[lever];
+    }
+    int64_t max_at(size_t lever) const {
+      return is_packed()
+                 ? lever_codec::unpack(*widths, *packed_bounds, lever, 2, 1)
+                 : token.max_values[lever];
+    }
+  };
+
+  TABLE controlvalue {
+    // token id
+    id_type id;
+    // current lever values of unpacked tokens
+    vector<int64_t> curr_values;
+    // current lever values packed with the token `lever_widths`
+    binary_extension<vector<char>> packed_values;
+
+    id_type primary_key() const { return id; }
+
+    int64_t value_at(const lever_layout &layout, size_t lever) const {
+      return layout.is_packed()
+                 ? lever_codec::unpack(*layout.widths, *packed_values, lever)
+                 : curr_values[lever];
+    }
+    void set_value(const lever_layout &layout, size_t lever, int64_t value) {
+      if (layout.is_packed()) {
+        lever_codec::set(*layout.widths, *packed_values, lever, value);
+      } else {
+        curr_values[lever] = value;
+      }
+    }
+  };
+
   TABLE auction {
     // token id
     id_type id;
@@ -252,14 +488,33 @@ public:
     // auction status. 0 auction. 1 end.
     int status;
 
+    // position of `bidder` for projected reads, so the row is serialized
+    // field by field rather than with EOSLIB_SERIALIZE
+    static constexpr size_t bidder_field = 1;
+
     id_type primary_key() const { return id; }
+    // open auctions ordered by end time, closed ones after all of them
+    uint64_t get_expiry() const {
+      return status == 0 ? end_time : numeric_limits<uint64_t>::max();
+    }
+
   };
 
+#ifdef CRYPTOART_LAYER_KEYS
+  // keyed (master id << 16) | layer index, the master being layer 0, so that
+  // an artwork is a single range of primary keys and needs no index
+  using control_token_table = multi_index<name("ctltokens"), controltoken>;
+#else
   using control_token_table =
       multi_index<name("ctltokens"), controltoken,
                   indexed_by<name("bymasterid"),
                              const_mem_fun<controltoken, id_type,
                                            &controltoken::get_master_id>>>;
+#endif
+
+  using control_value_table = multi_index<"ctlvalues"_n, controlvalue>;
+
+  using lever_schema_table = multi_index<"leverschemas"_n, leverschema>;
 
   using account_index = eosio::multi_index<"accounts"_n, account>;
 
@@ -268,18 +523,38 @@ public:
       indexed_by<"byissuer"_n,
                  const_mem_fun<stat, uint64_t, &stat::get_issuer>>>;
 
+  // slot 0 held the `byuuid` index of global ids, removed by `dropuuidx`.
+  // Slots 1 and 2 held separate `byowner`/`bysymbol` indexes, removed by
+  // `migratetidx`
   using token_index = eosio::multi_index<
       "tokens"_n, token,
-      indexed_by<"byuuid"_n, const_mem_fun<token, uint128_t, &token::get_uuid>>,
-      indexed_by<"byowner"_n,
-                 const_mem_fun<token, uint64_t, &token::get_owner>>,
-      indexed_by<"bysymbol"_n,
-                 const_mem_fun<token, uint64_t, &token::get_symbol>>>;
+      indexed_by<"byownersym"_n,
+                 const_mem_fun<token, uint128_t, &token::get_owner_symbol>,
+                 3>>;
 
-  using auction_index = multi_index<"auction"_n, auction>;
+  using auction_index = multi_index<
+      "auction"_n, auction,
+      indexed_by<"byexpiry"_n,
+                 const_mem_fun<auction, uint64_t, &auction::get_expiry>>>;
 
   using bid_qual = multi_index<"bidqual"_n, bid_qualification>;
 
+  TABLE clear_cursor {
+    // table being cleared, empty once everything is cleared
+    name table;
+    // primary key to resume erasing from
+    uint64_t next_id;
+  };
+
+  using clear_tokens_cursor = singleton<"clrtokens"_n, clear_cursor>;
+
+  using clear_auction_cursor = singleton<"clrauction"_n, clear_cursor>;
+
+  // key of the `byownersym` index, tokens of an owner grouped by symbol
+  static uint128_t owner_symbol_key(name owner, symbol_code sym) {
+    return (static_cast<uint128_t>(owner.value) << 64) | sym.raw();
+  }
+
   // generated token global uuid based on token id and
   // contract name, passed in the argument
   global_id get_global_id(name contract, id_type id) const {
@@ -292,28 +567,115 @@ public:
 private:
   token_index tokens;
   control_token_table control_tokens;
+  control_value_table control_values;
+  lever_schema_table lever_schemas;
   // 1000 PDH for per bid
   asset price_per_bid = asset(1000 * 10000, symbol("PDH", 4));
 
   string art_symbol = "ART";
+  string master_uri_prefix = "mobius://crypto.art/ART/master?ipfs=";
+  string layer_uri_prefix = "mobius://crypto.art/ART/layer?master=";
 
   void sub_balance(name owner, asset value);
   void add_balance(name owner, asset value, name ram_payer);
+  /**
+   * Apply net balance changes grouped per (owner, symbol). Each account row
+   * is written at most once, rows with zero net change are not touched.
+   * @param deltas - Net amount change per (owner, symbol)
+   * @param ram_payer - RAM payer of updated balance rows
+   */
+  void apply_balance_deltas(const map<pair<name, symbol>, int64_t> &deltas,
+                            name ram_payer);
   void sub_supply(asset quantity);
-  void add_supply(asset quantity);
-  /**
-   * Mint specified number of tokens with previously created symbol to the
-   * account name "to".
-   * Each token is generated with an unique token_id asiigned to it, and a URI
-   * format string.
-   * @param token_id - Avaliable master token id
-   * @param to - Issuer of the token
+  /**
+   * Give a token to `to`, updating the owner of its `tokens` row and of its
+   * control token row if it has one. Balances are left to the caller.
+   * @param token - Token row to transfer
+   * @param to - New owner
+   * @param ram_payer - RAM payer of the token row, and of the control token
+   * row if it has to grow to hold the owner
+   */
+  void _set_owner(const token &token, name to, name ram_payer);
+  /**
+   * Owner of a control token, read from the row itself when it holds one.
+   * @param token - Control token row
+   */
+  name _control_owner(const controltoken &token);
+  /**
+   * Find or store the lever schema holding `widths` and `packed_bounds`.
+   * A new row is billed to `ram_payer` and kept for as long as the table,
+   * tokens reusing it later are not billed for it.
+   * @param widths - Storage width of each lever
+   * @param packed_bounds - Packed (min, max) bounds of each lever
+   * @param ram_payer - RAM payer of the schema row if it is new
+   * @return Id of the schema row
+   */
+  uint64_t _intern_schema(const vector<uint8_t> &widths,
+                          const vector<char> &packed_bounds, name ram_payer);
+  /**
+   * Lever widths and bounds of a set up control token.
+   * @param token - Control token row
+   */
+  lever_layout _lever_layout(const controltoken &token);
+  /**
+   * Move current values of a legacy control token row into `ctlvalues`.
+   * @param token - Control token still holding its current values
+   * @param ram_payer - Account paying for the `ctlvalues` row
+   * @return Iterator to the created `ctlvalues` row
+   */
+  control_value_table::const_iterator
+  _migrate_values(const controltoken &token, name ram_payer);
+  /**
+   * Mint a batch of tokens with previously created symbol. Token `i` is
+   * generated with id `first_id + i`, sent to `owners[i]` and assigned
+   * `uris[i]`. The first token is also assigned `first_cid`.
+   * The stat row is read once for the whole batch: issuer authorization and
+   * maximum supply are checked once, and `issued`/`supply` are written once.
+   * @param first_id - Avaliable id of the first token
+   * @param owners - Receiver of each token
    * @param symbol - Token symbol
-   * @param uri - URI string of token. Seed the RFC 3986
-   * @param memo - Action memo. Maximum 256 bytes
+   * @param uris - URI string of each token. Seed the RFC 3986
+   * @param first_cid - Binary CID of the first token, may be empty
+   * @return Issuer of the token, who pays for RAM
+   */
+  name _mintbatch(id_type first_id, const vector<name> &owners, string symbol,
+                  const vector<string> &uris, const vector<char> &first_cid);
+
+  /**
+   * Close an auction, pay the token owner and transfer the token to the top
+   * bidder. Auctions without any bid are only closed.
+   * @param auctions - Auction table holding `record`
+   * @param record - Open auction to settle
+   * @param ram_payer - RAM payer of the transferred token row
    */
-  id_type _safemint(id_type token_id, name to, string symbol, string uri,
-                    string memo);
+  void _settle_auction(auction_index &auctions, const auction &record,
+                       name ram_payer);
+
+  /**
+   * Erase rows of `table` from `cursor.next_id` while `max_rows` allows,
+   * without deserializing them. Once the table is empty the cursor moves to
+   * `next_table`.
+   * @param table - Table being cleared
+   * @param cursor - Clear cursor, updated to the next row to erase
+   * @param max_rows - Remaining rows allowed, decreased by erased rows
+   * @param next_table - Table to clear after this one
+   * @param on_erase - Called with the primary key and secondary keys of each
+   * row before it is erased
+   */
+  template <typename Table, typename Callback>
+  void _clear_table(Table &table, clear_cursor &cursor, uint64_t &max_rows,
+                    name next_table, Callback &&on_erase) {
+    auto next = table.truncate(cursor.next_id, max_rows,
+                               [&](uint64_t pk, const auto &keys) {
+                                 on_erase(pk, keys);
+                                 max_rows--;
+                               });
+    if (next.has_value()) {
+      cursor.next_id = *next;
+    } else {
+      cursor = clear_cursor{next_table, 0};
+    }
+  }
 
   int64_t now() { return current_time_point().time_since_epoch().to_seconds(); }
 };
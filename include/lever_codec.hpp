@@ -0,0 +1,186 @@
+#pragma once
+#include <eosio/check.hpp>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+/**
+ * Packed storage of control token lever values.
+ *
+ * Every lever has a width code. Fixed widths (1, 2, 4 or 8) store the value as
+ * a little-endian two's complement integer of that many bytes, and their
+ * unsigned codes (`unsigned_flag` set) as an unsigned one, for levers whose
+ * minimum is not negative. `varint` stores it as a zigzag LEB128 integer. A packed buffer may hold several
+ * values per lever (e.g. min and max bounds), stored next to each other.
+ */
+namespace lever_codec {
+
+constexpr uint8_t unsigned_flag = 0x80;
+
+enum width : uint8_t {
+  varint = 0,
+  int8 = 1,
+  int16 = 2,
+  int32 = 4,
+  int64 = 8,
+  uint8 = unsigned_flag | 1,
+  uint16 = unsigned_flag | 2,
+  uint32 = unsigned_flag | 4
+};
+
+// longest zigzag LEB128 encoding of a 64 bit value
+constexpr size_t max_varint_size = 10;
+
+inline bool is_valid(uint8_t w) {
+  return w == varint || w == int8 || w == int16 || w == int32 ||
+         w == int64 || w == uint8 || w == uint16 || w == uint32;
+}
+
+inline bool is_unsigned(uint8_t w) { return w & unsigned_flag; }
+
+// Number of bytes of a fixed width.
+inline size_t byte_count(uint8_t w) { return w & ~unsigned_flag; }
+
+// Whether `value` can be stored with width `w`.
+inline bool fits(uint8_t w, int64_t value) {
+  if (w == varint || w == int64) {
+    return true;
+  }
+  if (is_unsigned(w)) {
+    return value >= 0 && uint64_t(value) < uint64_t(1) << (byte_count(w) * 8);
+  }
+  int64_t limit = int64_t(1) << (byte_count(w) * 8 - 1);
+  return value >= -limit && value < limit;
+}
+
+// Unsigned code of the fixed width `w` if `lo`, the lever minimum, is not
+// negative, `w` otherwise.
+inline uint8_t with_sign_of(uint8_t w, int64_t lo) {
+  bool has_unsigned = w == int8 || w == int16 || w == int32;
+  return has_unsigned && lo >= 0 ? w | unsigned_flag : w;
+}
+
+// Narrowest fixed width holding every value in [lo, hi].
+inline uint8_t narrowest(int64_t lo, int64_t hi) {
+  for (uint8_t w : {int8, int16, int32}) {
+    w = with_sign_of(w, lo);
+    if (fits(w, lo) && fits(w, hi)) {
+      return w;
+    }
+  }
+  return int64;
+}
+
+// Number of bytes of the value stored at `pos` of `data` with width `w`.
+inline size_t encoded_size(uint8_t w, const std::vector<char> &data,
+                           size_t pos) {
+  if (w != varint) {
+    return byte_count(w);
+  }
+  size_t n = 0;
+  do {
+    eosio::check(pos + n < data.size() && n < max_varint_size,
+                 "lever value out of packed range");
+  } while (uint8_t(data[pos + n++]) & 0x80);
+  return n;
+}
+
+inline void append(std::vector<char> &out, uint8_t w, int64_t value) {
+  eosio::check(fits(w, value), "lever value does not fit its width");
+  uint64_t u = uint64_t(value);
+  if (w == varint) {
+    u = (u << 1) ^ uint64_t(value >> 63);
+    do {
+      uint8_t b = u & 0x7f;
+      u >>= 7;
+      out.push_back(char(u ? b | 0x80 : b));
+    } while (u);
+    return;
+  }
+  for (size_t i = 0; i < byte_count(w); i++, u >>= 8) {
+    out.push_back(char(u & 0xff));
+  }
+}
+
+// Value stored at `p` with width `w`, whose bytes were checked by `offset`.
+inline int64_t read(uint8_t w, const char *p) {
+  uint64_t u = 0;
+  if (w == varint) {
+    uint8_t b;
+    int shift = 0;
+    do {
+      b = uint8_t(*p++);
+      u |= uint64_t(b & 0x7f) << shift;
+      shift += 7;
+    } while (b & 0x80);
+    return int64_t(u >> 1) ^ -int64_t(u & 1);
+  }
+  for (size_t i = 0; i < byte_count(w); i++) {
+    u |= uint64_t(uint8_t(p[i])) << (8 * i);
+  }
+  if (is_unsigned(w)) {
+    return int64_t(u);
+  }
+  int shift = 64 - 8 * byte_count(w);
+  return int64_t(u << shift) >> shift;
+}
+
+// Byte offset of value `field` of `lever`, with `fields` values per lever.
+// Every byte of that value is checked to be inside `data`.
+inline size_t offset(const std::vector<uint8_t> &widths,
+                     const std::vector<char> &data, size_t lever,
+                     size_t fields = 1, size_t field = 0) {
+  size_t pos = 0;
+  for (size_t i = 0; i < lever; i++) {
+    if (widths[i] != varint) {
+      pos += byte_count(widths[i]) * fields;
+      continue;
+    }
+    for (size_t f = 0; f < fields; f++) {
+      pos += encoded_size(varint, data, pos);
+    }
+  }
+  for (size_t f = 0; f < field; f++) {
+    pos += encoded_size(widths[lever], data, pos);
+  }
+  eosio::check(pos + encoded_size(widths[lever], data, pos) <= data.size(),
+               "lever value out of packed range");
+  return pos;
+}
+
+// Pack `values[f][i]` as value `f` of lever `i`.
+inline std::vector<char>
+pack(const std::vector<uint8_t> &widths,
+     std::initializer_list<const std::vector<int64_t> *> values) {
+  std::vector<char> out;
+  out.reserve(widths.size() * values.size());
+  for (size_t i = 0; i < widths.size(); i++) {
+    for (auto field : values) {
+      append(out, widths[i], (*field)[i]);
+    }
+  }
+  return out;
+}
+
+inline int64_t unpack(const std::vector<uint8_t> &widths,
+                      const std::vector<char> &data, size_t lever,
+                      size_t fields = 1, size_t field = 0) {
+  return read(widths[lever],
+              data.data() + offset(widths, data, lever, fields, field));
+}
+
+// Overwrite the single value of `lever`, resizing the buffer for varints.
+inline void set(const std::vector<uint8_t> &widths, std::vector<char> &data,
+                size_t lever, int64_t value) {
+  size_t pos = offset(widths, data, lever);
+  size_t old_size = encoded_size(widths[lever], data, pos);
+  std::vector<char> enc;
+  append(enc, widths[lever], value);
+  if (enc.size() != old_size) {
+    data.erase(data.begin() + pos, data.begin() + pos + old_size);
+    data.insert(data.begin() + pos, enc.size(), 0);
+  }
+  memcpy(data.data() + pos, enc.data(), enc.size());
+}
+
+} // namespace lever_codec
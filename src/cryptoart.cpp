@@ -33,15 +33,16 @@ ACTION cryptoart::create(name issuer, asset max_supply) {
   });
 }
 
-id_type cryptoart::_safemint(id_type token_id, name to, string symbol,
-                             string uri, string memo) {
-  check(is_account(to), "to account does not exist");
+name cryptoart::_mintbatch(id_type first_id, const vector<name> &owners,
+                           string symbol, const vector<string> &uris,
+                           const vector<char> &first_cid) {
+  check(owners.size() == uris.size(), "owners and uris size should be equal");
   // e,g, Get EOS from 3 EOS
   auto sym = eosio::symbol(symbol.c_str(), 0);
-  auto quantity = asset(1, sym);
   check(sym.is_valid(), "invalid symbol name");
-  check(sym.precision() == 0, "quantity must be a whole number");
-  check(memo.size() <= 256, "memo has more than 256 bytes");
+  auto quantity = asset(owners.size(), sym);
+  check(quantity.is_valid(), "invalid quantity");
+  check(quantity.amount > 0, "must issue positive quantity");
 
   // Ensure currency has been created
   auto sym_code = sym.code().raw();
@@ -50,22 +51,37 @@ id_type cryptoart::_safemint(id_type token_id, name to, string symbol,
       sym_code, "token with symbol does not exist. create token before issue");
   // Ensure have issuer authorization and valid quantity
   require_auth(st.issuer);
+  check(st.infinite || st.issued + quantity <= st.max_supply,
+        "quantity should not be more than maximum supply");
 
-  // Increase supply
-  statstable.modify(st, same_payer, [&](auto &s) { s.issued += quantity; });
-
-  add_supply(quantity);
-  // Add balance to account
-  add_balance(to, quantity, to);
+  // Add balance to accounts, once per receiver. Receivers have not
+  // authorized the action, so the issuer pays for new balance rows.
+  map<name, int64_t> minted;
+  for (auto owner : owners) {
+    minted[owner] += 1;
+  }
+  for (const auto &m : minted) {
+    check(is_account(m.first), "to account does not exist");
+    add_balance(m.first, asset(m.second, sym), st.issuer);
+  }
   // Mint nfts. Issuer will pay for RAM
-  tokens.emplace(get_issuer(sym.code()), [&](auto &token) {
-    token.id = token_id;
-    token.uuid = get_global_id(get_self(), token_id);
-    token.uri = uri;
-    token.owner = to;
-    token.value = asset(1, sym);
+  for (size_t i = 0; i < owners.size(); i++) {
+    id_type token_id = first_id + i;
+    tokens.emplace(st.issuer, [&](auto &token) {
+      token.id = token_id;
+      token.uuid = get_global_id(get_self(), token_id);
+      token.uri = uris[i];
+      token.owner = owners[i];
+      token.value = asset(1, sym);
+      token.cid.emplace(i == 0 ? first_cid : vector<char>());
+    });
+  }
+  // Increase supply
+  statstable.modify(st, same_payer, [&](auto &s) {
+    s.issued += quantity;
+    s.supply += quantity;
   });
-  return token_id;
+  return st.issuer;
 }
 
 ACTION cryptoart::transfer(name from, name to, id_type token_id, string memo) {
@@ -89,13 +105,53 @@ ACTION cryptoart::transfer(name from, name to, id_type token_id, string memo) {
   require_recipient(to);
 
   // Transfer NFT from sender to receiver
-  tokens.modify(st, from, [&](auto &token) { token.owner = to; });
+  _set_owner(st, to, from);
 
   // Change balance of both accounts
   sub_balance(from, st.value);
   add_balance(to, st.value, from);
 }
 
+ACTION cryptoart::transferbatch(name from, vector<id_type> token_ids,
+                                vector<name> recipients, string memo) {
+  // Ensure authorized to send from account
+  require_auth(from);
+
+  check(token_ids.size() == recipients.size(),
+        "length of token_ids should be equal to recipients");
+
+  // Check memo size and print
+  check(memo.size() <= 256, "memo has more than 256 bytes");
+
+  map<pair<name, symbol>, int64_t> deltas;
+  set<name> receivers;
+  for (size_t i = 0; i < token_ids.size(); i++) {
+    name to = recipients[i];
+    // Ensure token ID exists
+    const auto &st = tokens.get(token_ids[i], "token does not exist");
+
+    // Ensure owner owns token
+    check(st.owner == from, "sender does not own token with specified ID");
+
+    // Transfer NFT from sender to receiver
+    _set_owner(st, to, from);
+
+    deltas[{from, st.value.symbol}] -= st.value.amount;
+    deltas[{to, st.value.symbol}] += st.value.amount;
+    receivers.insert(to);
+  }
+
+  // Ensure 'to' accounts exist and notify all recipients
+  require_recipient(from);
+  for (auto to : receivers) {
+    check(is_account(to), "to account does not exist");
+    require_recipient(to);
+  }
+
+  // Change balance of all accounts
+  apply_balance_deltas(deltas, from);
+}
+
 ACTION cryptoart::setrampayer(name payer, id_type id) {
   require_auth(payer);
 
@@ -112,25 +168,24 @@ ACTION cryptoart::setrampayer(name payer, id_type id) {
   // Notify payer
   require_recipient(payer);
 
-  // Set owner as a RAM payer
-  tokens.modify(payer_token, payer, [&](auto &token) {
-    token.id = st.id;
-    token.uri = st.uri;
-    token.owner = st.owner;
-    token.value = st.value;
-  });
+  // Set owner as a RAM payer of the token and its balance rows, nothing
+  // else changes so rows already billed to the owner here are not written
+  tokens.modify_if_changed(payer_token, payer, [](auto &) {});
 
-  sub_balance(payer, st.value);
-  add_balance(payer, st.value, payer);
+  account_index accounts(get_self(), payer.value);
+  const auto &account =
+      accounts.get(st.value.symbol.code().raw(), "no balance object found");
+  accounts.modify_if_changed(account, payer, [](auto &) {});
 }
 
 // ACTION cryptoart::burn(name owner, global_id uuid, string memo) {
 //   require_auth(owner);
 
 //   // Find token to burn
-//   auto uuid_index = tokens.get_index<"byuuid"_n>();
-//   const auto &burn_token = uuid_index.get(uuid, "token with id does not
-//   exist"); check(burn_token.owner == owner, "token not owned by account");
+//   auto itr = find_by_uuid(uuid);
+//   check(itr != tokens.end(), "token with id does not exist");
+//   const auto &burn_token = *itr;
+//   check(burn_token.owner == owner, "token not owned by account");
 
 //   asset burnt_supply = burn_token.value;
 
@@ -161,7 +216,21 @@ void cryptoart::add_balance(name owner, asset value, name ram_payer) {
   if (to == to_accounts.end()) {
     to_accounts.emplace(ram_payer, [&](auto &a) { a.balance = value; });
   } else {
-    to_accounts.modify(to, ram_payer, [&](auto &a) { a.balance += value; });
+    to_accounts.modify_if_changed(to, ram_payer,
+                                  [&](auto &a) { a.balance += value; });
+  }
+}
+
+void cryptoart::apply_balance_deltas(
+    const map<pair<name, symbol>, int64_t> &deltas, name ram_payer) {
+  for (const auto &d : deltas) {
+    name owner = d.first.first;
+    symbol sym = d.first.second;
+    if (d.second < 0) {
+      sub_balance(owner, asset(-d.second, sym));
+    } else if (d.second > 0) {
+      add_balance(owner, asset(d.second, sym), ram_payer);
+    }
   }
 }
 
@@ -174,25 +243,40 @@ void cryptoart::sub_supply(asset quantity) {
                         [&](auto &currency) { currency.supply -= quantity; });
 }
 
-void cryptoart::add_supply(asset quantity) {
-  auto sym_code = quantity.symbol.code().raw();
-  check(quantity.is_valid(), "invalid quantity");
-  check(quantity.amount > 0, "must issue positive quantity");
-
-  stat_index currency_table(get_self(), get_self().value);
-  const auto &st = currency_table.get(sym_code, "asset does not exist");
+void cryptoart::_set_owner(const token &token, name to, name ram_payer) {
+  // tokens not yet covered by `migratetidx` have no `byownersym` entry for
+  // modify to update
+  tokens.backfill_index<"byownersym"_n>(token.id, 1, get_self());
+  tokens.modify(token, ram_payer, [&](auto &r) { r.owner = to; });
+  auto ctl = control_tokens.find(token.id);
+  if (ctl == control_tokens.end()) {
+    return;
+  }
+  if (ctl->owner.has_value()) {
+    // same size, nobody pays for more RAM
+    control_tokens.modify(ctl, same_payer,
+                          [&](auto &r) { r.owner.emplace(to); });
+  } else if (ram_payer != same_payer) {
+    control_tokens.modify(ctl, ram_payer,
+                          [&](auto &r) { r.owner.emplace(to); });
+  }
+  // otherwise the owner stays unknown and is read from `tokens`
+}
 
-  check(st.infinite || st.issued + quantity < st.max_supply,
-        "quantity should not be more than maximum supply");
-  currency_table.modify(st, same_payer,
-                        [&](auto &currency) { currency.supply += quantity; });
+name cryptoart::_control_owner(const controltoken &token) {
+  name owner = token.owner.value_or();
+  return owner != name() ? owner : get_owner_by_id(token.id);
 }
 
 ACTION cryptoart::setuptoken(id_type token_id, vector<int64_t> min_values,
                              vector<int64_t> max_values,
-                             vector<int64_t> curr_values) {
+                             vector<int64_t> curr_values,
+                             binary_extension<vector<uint8_t>> lever_widths) {
+  // get the token that is not setup
+  const auto &token = control_tokens.get(token_id, "token not found");
+  check(token.is_setup == false, "token was setup");
   // require owner's auth
-  name owner = get_owner_by_id(token_id);
+  name owner = _control_owner(token);
   require_auth(owner);
 
   // check the length of values lists are equal or not
@@ -200,75 +284,265 @@ ACTION cryptoart::setuptoken(id_type token_id, vector<int64_t> min_values,
             max_values.size() == curr_values.size(),
         "values array size should be equal");
   auto levers_num = min_values.size();
-  // get the token that is not setup
-  const auto &token = control_tokens.get(token_id, "token not found");
-  check(token.is_setup == false, "token was setup");
-  // modify token structure to setup initial values
-  control_tokens.modify(token, same_payer, [&](auto &r) {
+  vector<uint8_t> widths;
+  if (lever_widths.has_value() && !lever_widths->empty()) {
+    widths = *lever_widths;
+    check(widths.size() == levers_num,
+          "lever_widths size should be equal to values size");
+    for (size_t i = 0; i < levers_num; i++) {
+      check(lever_codec::is_valid(widths[i]),
+            "lever width should be 0, 1, 2, 4 or 8");
+      // levers without negative values are stored unsigned
+      widths[i] = lever_codec::with_sign_of(widths[i], min_values[i]);
+    }
+  } else {
+    // pick the narrowest width holding the bounds of each lever
+    widths.reserve(levers_num);
+    for (size_t i = 0; i < levers_num; i++) {
+      widths.push_back(lever_codec::narrowest(min_values[i], max_values[i]));
+    }
+  }
+  // bounds are shared with every token set up with the same ones
+  uint64_t schema_id = _intern_schema(
+      widths, lever_codec::pack(widths, {&min_values, &max_values}), owner);
+  // modify token structure to point to its schema, the row grows so the
+  // owner setting it up pays for it
+  control_tokens.modify(token, owner, [&](auto &r) {
     r.is_setup = true;
     r.levers_num = levers_num;
-    r.min_values = min_values;
-    r.max_values = max_values;
-    r.curr_values = curr_values;
+    r.min_values.clear();
+    r.max_values.clear();
+    r.curr_values.clear();
+    r.lever_widths.emplace();
+    r.packed_bounds.emplace();
+    r.schema_id.emplace(schema_id);
+  });
+  // current values live in their own row, so updates never rewrite bounds.
+  // Its size is chosen by the owner, who pays for it
+  control_values.emplace(owner, [&](auto &r) {
+    r.id = token_id;
+    r.packed_values.emplace(lever_codec::pack(widths, {&curr_values}));
   });
 }
 
 ACTION cryptoart::mintartwork(id_type master_token_id, name to, string uri,
                               vector<name> collaborators) {
-  name issuer = get_issuer(symbol_code(art_symbol));
-  require_auth(issuer);
-  // issue master layer token
-  _safemint(master_token_id, to, art_symbol,
-            "mobius://crypto.art/ART/master?ipfs=" + uri, string(""));
+#ifdef CRYPTOART_LAYER_KEYS
+  // the master is layer 0 of its own key range, see `control_token_table`
+  check(master_token_id <= (numeric_limits<id_type>::max() >> 16),
+        "master token id out of range");
+  check(collaborators.size() <= 0xffff, "too many collaborators");
+  master_token_id <<= 16;
+#endif
+  // master layer goes to `to`, layer tokens to initial collaborators
+  vector<name> owners;
+  owners.reserve(collaborators.size() + 1);
+  owners.push_back(to);
+  owners.insert(owners.end(), collaborators.begin(), collaborators.end());
+  // master uris of CIDv0 are stored as the binary multihash, layer uris are
+  // not stored at all. Both are rebuilt by `get_token_uri`
+  vector<char> cid = cid_codec::to_multihash(uri);
+  vector<string> uris(owners.size());
+  if (cid.empty()) {
+    uris[0] = master_uri_prefix + uri;
+  }
+  name issuer = _mintbatch(master_token_id, owners, art_symbol, uris, cid);
+
   control_tokens.emplace(issuer, [&](auto &r) {
     // `token_id` and `master_token_id` are the same in master token
     r.id = master_token_id;
     r.master_token_id = master_token_id;
     r.levers_num = 0;
     r.is_setup = true;
+    r.owner.emplace(to);
+    r.layers_num.emplace(collaborators.size());
   });
-  // issue layer token to initial collaborators
-  for (int i = 0; i < collaborators.size(); i++) {
-    name collaborator = collaborators[i];
+  for (size_t i = 0; i < collaborators.size(); i++) {
     id_type available_id = master_token_id + i + 1;
-    _safemint(available_id, collaborator, art_symbol,
-              "mobius://crypto.art/ART/layer?master=" +
-                  to_string(master_token_id),
-              string(""));
     control_tokens.emplace(issuer, [&](auto &r) {
       r.id = available_id;
       r.is_setup = false;
       r.master_token_id = master_token_id;
+      r.owner.emplace(collaborators[i]);
     });
   }
 }
 
+uint64_t cryptoart::_intern_schema(const vector<uint8_t> &widths,
+                                   const vector<char> &packed_bounds,
+                                   name ram_payer) {
+  auto packed = pack(make_tuple(widths, packed_bounds));
+  checksum256 hash = sha256(packed.data(), packed.size());
+  // ids are the low 64 bits of the hash, the next free one on collision
+  for (uint64_t id = uint64_t(hash.get_array()[0]);; id++) {
+    if (id == 0) {
+      continue;
+    }
+    auto schema = lever_schemas.find(id);
+    if (schema == lever_schemas.end()) {
+      lever_schemas.emplace(ram_payer, [&](auto &r) {
+        r.id = id;
+        r.hash = hash;
+        r.lever_widths = widths;
+        r.packed_bounds = packed_bounds;
+      });
+      return id;
+    }
+    // shared rows are only read, their payer stays the first one
+    if (schema->hash == hash) {
+      return id;
+    }
+  }
+}
+
+cryptoart::lever_layout
+cryptoart::_lever_layout(const controltoken &token) {
+  uint64_t schema_id = token.schema_id.value_or();
+  if (schema_id != 0) {
+    const auto &schema =
+        lever_schemas.get(schema_id, "lever schema not found");
+    return {token, &schema.lever_widths, &schema.packed_bounds};
+  }
+  if (token.lever_widths.has_value()) {
+    return {token, &*token.lever_widths, &*token.packed_bounds};
+  }
+  return {token, nullptr, nullptr};
+}
+
 ACTION cryptoart::updatetoken(id_type token_id, vector<int64_t> lever_ids,
                               vector<int64_t> new_values) {
-  name owner = get_owner_by_id(token_id);
+  const auto &token = control_tokens.get(token_id, "token not found");
+  name owner = _control_owner(token);
   require_auth(owner);
 
   check(lever_ids.size() == new_values.size(),
         "length of lever_ids should be equal to new_values");
-  const auto &token = control_tokens.get(token_id, "token not found");
   check(token.is_setup, "token is not setup");
-  vector<int64_t> values = token.curr_values;
-  for (int i = 0; i < lever_ids.size(); i++) {
-    int lever_id = lever_ids[i];
+  auto values = control_values.find(token_id);
+  if (values == control_values.end()) {
+    // only legacy rows still carry their current values, tokens without
+    // levers have nothing to update
+    if (token.curr_values.empty()) {
+      check(lever_ids.empty(), "lever id should be lower than values length");
+      return;
+    }
+    values = _migrate_values(token, owner);
+  }
+  auto layout = _lever_layout(token);
+  for (size_t i = 0; i < lever_ids.size(); i++) {
+    auto lever_id = lever_ids[i];
     auto new_value = new_values[i];
-    check(lever_id < token.curr_values.size(),
+    check(lever_id >= 0 && uint64_t(lever_id) < token.levers_num,
           "lever id should be lower than values length");
-    check(new_value >= token.min_values[lever_id] &&
-              new_value <= token.max_values[lever_id],
-          "new value should be at the range of [" +
-              to_string(token.min_values[lever_id]) + "," +
-              to_string(token.max_values[lever_id]) + "]");
-    values[lever_id] = new_value;
+    auto min_value = layout.min_at(lever_id);
+    auto max_value = layout.max_at(lever_id);
+    check(new_value >= min_value && new_value <= max_value,
+          "new value should be at the range of [" + to_string(min_value) +
+              "," + to_string(max_value) + "]");
   }
+  // idempotent updates leave the row as it was and write nothing
+  control_values.modify_if_changed(values, same_payer, [&](auto &r) {
+    for (size_t i = 0; i < lever_ids.size(); i++) {
+      r.set_value(layout, lever_ids[i], new_values[i]);
+    }
+  });
+}
+
+cryptoart::control_value_table::const_iterator
+cryptoart::_migrate_values(const controltoken &token, name ram_payer) {
+  auto values = control_values.emplace(ram_payer, [&](auto &r) {
+    r.id = token.id;
+    r.curr_values = token.curr_values;
+  });
   control_tokens.modify(token, same_payer,
-                        [&](auto &r) { r.curr_values = values; });
+                        [&](auto &r) { r.curr_values.clear(); });
+  return values;
+}
+
+ACTION cryptoart::migratevals(id_type from_id, uint64_t max_rows) {
+  require_auth(get_self());
+  auto itr = control_tokens.lower_bound(from_id);
+  for (uint64_t i = 0; i < max_rows && itr != control_tokens.end(); i++) {
+    // only legacy rows still carry their current values
+    if (!itr->curr_values.empty()) {
+      _migrate_values(*itr, get_self());
+    }
+    itr++;
+  }
+  if (itr != control_tokens.end()) {
+    print("next id: ", itr->id);
+  }
+}
+
+ACTION cryptoart::migrateuris(id_type from_id, uint64_t max_rows) {
+  require_auth(get_self());
+  auto itr = tokens.lower_bound(from_id);
+  for (uint64_t i = 0; i < max_rows && itr != tokens.end(); i++) {
+    const string &uri = itr->uri;
+    vector<char> cid;
+    bool derived = false;
+    if (uri.compare(0, master_uri_prefix.size(), master_uri_prefix) == 0) {
+      cid = cid_codec::to_multihash(uri.substr(master_uri_prefix.size()));
+      derived = !cid.empty();
+    } else if (uri.compare(0, layer_uri_prefix.size(), layer_uri_prefix) ==
+               0) {
+      // only layer uris that can be rebuilt from `ctltokens`
+      auto ctl = control_tokens.find(itr->id);
+      derived = ctl != control_tokens.end() &&
+                uri == layer_uri_prefix + to_string(ctl->master_token_id);
+    }
+    if (derived) {
+      // the row shrinks, so its payer is refunded
+      tokens.modify(itr, same_payer, [&](auto &r) {
+        r.uri.clear();
+        r.cid.emplace(cid);
+      });
+    }
+    itr++;
+  }
+  if (itr != tokens.end()) {
+    print("next id: ", itr->id);
+  }
+}
+
+ACTION cryptoart::dropuuidx(uint64_t max_entries) {
+  require_auth(get_self());
+  if (tokens.drop_index<uint128_t>(0, max_entries)) {
+    print("entries left");
+  } else {
+    print("done");
+  }
+}
+
+ACTION cryptoart::migratetidx(id_type from_id, uint64_t max_rows) {
+  require_auth(get_self());
+  auto next = tokens.backfill_index<"byownersym"_n>(from_id, max_rows, get_self());
+  if (next.has_value()) {
+    print("next id: ", *next);
+    return;
+  }
+  // every token is indexed, drop the `byowner` then the `bysymbol` entries
+  if (tokens.drop_index<uint64_t>(1, max_rows) ||
+      tokens.drop_index<uint64_t>(2, max_rows)) {
+    print("entries left");
+  } else {
+    print("done");
+  }
+}
+
+string cryptoart::get_token_uri(id_type token_id) {
+  const auto &token = tokens.get(token_id, "token not found");
+  if (!token.uri.empty()) {
+    return token.uri;
+  }
+  if (token.cid.has_value() && !token.cid->empty()) {
+    return master_uri_prefix + cid_codec::encode(*token.cid);
+  }
+  return layer_uri_prefix + to_string(get_master(token_id));
 }
 
+ACTION cryptoart::geturi(id_type token_id) { print(get_token_uri(token_id)); }
+
 void cryptoart::payeos(name from, name to, asset quantity, string memo) {
   if (to != get_self()) {
     print("receiver should be the contract account");
@@ -370,7 +644,7 @@ ACTION cryptoart::acceptbid(id_type token_id) {
         .send();
   }
   // transfer artwork
-  tokens.modify(token, token.owner, [&](auto &r) { r.owner = record.bidder; });
+  _set_owner(token, record.bidder, token.owner);
 }
 
 void cryptoart::paypdh(name from, name to, asset quantity, string memo) {
@@ -417,9 +691,35 @@ ACTION cryptoart::auctionend(id_type token_id) {
   check(record.status == 0, "auction has closed");
   check(record.end_time < now(),
         "auction cannot be ended before the pre-defined end time");
+  _settle_auction(auction, record, record.bidder);
+}
+
+ACTION cryptoart::settleexpired(uint64_t max_count) {
+  auction_index auction(get_self(), get_self().value);
+  auto expiry_index = auction.get_index<"byexpiry"_n>();
+  uint64_t now_seconds = now();
+  uint64_t settled = 0;
+  auto itr = expiry_index.begin();
+  while (settled < max_count && itr != expiry_index.end() &&
+         itr->get_expiry() < now_seconds) {
+    const auto &record = *itr;
+    // step over the record before settling moves it to the closed range
+    itr++;
+    _settle_auction(auction, record, same_payer);
+    settled++;
+  }
+  print("settled: ", settled);
+}
+
+void cryptoart::_settle_auction(auction_index &auctions, const auction &record,
+                                name ram_payer) {
   // close the auction.
-  auction.modify(record, same_payer, [&](auto &r) { r.status = 1; });
-  const auto &token = tokens.get(token_id, "token not found");
+  auctions.modify(record, same_payer, [&](auto &r) { r.status = 1; });
+  const auto &token = tokens.get(record.id, "token not found");
+  // nobody bid, the token stays with its owner.
+  if (record.bidder == token.owner) {
+    return;
+  }
   // transfer EOS to token owner.
   if (token.owner != get_self()) {
     action(permission_level(get_self(), "active"_n), "eosio.token"_n,
@@ -429,28 +729,108 @@ ACTION cryptoart::auctionend(id_type token_id) {
         .send();
   }
   // transfer artwork
-  tokens.modify(token, record.bidder,
-                [&](auto &r) { r.owner = record.bidder; });
+  _set_owner(token, record.bidder, ram_payer);
 }
 
-ACTION cryptoart::clearauction() {
+ACTION cryptoart::migrateauct(id_type from_id, uint64_t max_rows) {
   require_auth(get_self());
-  auction_index acc(get_self(), get_self().value);
-  auto itr = acc.begin();
-  while (itr != acc.end()) {
-    itr = acc.erase(itr);
+  auction_index auctions(get_self(), get_self().value);
+  // rows keep their payer, the contract pays for the new index entries
+  auto next =
+      auctions.backfill_index<"byexpiry"_n>(from_id, max_rows, get_self());
+  if (next.has_value()) {
+    print("next id: ", *next);
   }
 }
 
-ACTION cryptoart::cleartokens() {
+ACTION cryptoart::clearauction(uint64_t max_rows) {
   require_auth(get_self());
-  auto itr = control_tokens.begin();
-  while (itr != control_tokens.end()) {
-    itr = control_tokens.erase(itr);
+  check(max_rows > 0, "max_rows should be positive");
+  clear_auction_cursor cursor_table(get_self(), get_self().value);
+  auto cursor = cursor_table.get_or_default(clear_cursor{"auction"_n, 0});
+
+  if (cursor.table == "auction"_n) {
+    auction_index acc(get_self(), get_self().value);
+    _clear_table(acc, cursor, max_rows, name(), [&](uint64_t id, const auto &) {
+      // only the bidder is decoded, the row is not loaded
+      name bidder = get<0>(*acc.get_fields<auction::bidder_field>(id));
+      bid_qual qual(get_self(), bidder.value);
+      auto q = qual.find(bidder.value);
+      if (q != qual.end()) {
+        qual.erase(q);
+      }
+    });
   }
 
-  auto itr2 = tokens.begin();
-  while (itr2 != tokens.end()) {
-    itr2 = tokens.erase(itr2);
+  if (cursor.table == name()) {
+    cursor_table.remove();
+    print("done");
+  } else {
+    cursor_table.set(cursor, get_self());
+    print("remaining: ", cursor.table, " from id ", cursor.next_id);
   }
-}
\ No newline at end of file
+}
+
+ACTION cryptoart::cleartokens(uint64_t max_rows) {
+  require_auth(get_self());
+  check(max_rows > 0, "max_rows should be positive");
+  clear_tokens_cursor cursor_table(get_self(), get_self().value);
+  auto cursor = cursor_table.get_or_default(clear_cursor{"ctltokens"_n, 0});
+  auto skip = [](uint64_t, const auto &) {};
+
+  if (cursor.table == "ctltokens"_n) {
+    _clear_table(control_tokens, cursor, max_rows, "ctlvalues"_n, skip);
+  }
+  if (cursor.table == "ctlvalues"_n) {
+    _clear_table(control_values, cursor, max_rows, "leverschemas"_n, skip);
+  }
+  if (cursor.table == "leverschemas"_n) {
+    _clear_table(lever_schemas, cursor, max_rows, "tokens"_n, skip);
+  }
+  if (cursor.table == "tokens"_n) {
+    // owner and symbol are read from the `byownersym` index key
+    _clear_table(tokens, cursor, max_rows, "tokenidx"_n, [&](uint64_t, const auto &keys) {
+      account_index acnts(get_self(), uint64_t(get<0>(keys) >> 64));
+      auto a = acnts.find(uint64_t(get<0>(keys)));
+      if (a != acnts.end()) {
+        acnts.erase(a);
+      }
+    });
+  }
+  if (cursor.table == "tokenidx"_n && max_rows > 0) {
+    // entries of the `byuuid`, `byowner` and `bysymbol` indexes in slots 0
+    // to 2, left by tokens cleared before `dropuuidx` and `migratetidx`.
+    // drop_index does not tell how many it removed, so a call drops from a
+    // single slot and ends there
+    uint64_t slot = cursor.next_id;
+    bool more = slot == 0 ? tokens.drop_index<uint128_t>(slot, max_rows)
+                          : tokens.drop_index<uint64_t>(slot, max_rows);
+    if (!more) {
+      cursor = slot < 2 ? clear_cursor{"tokenidx"_n, slot + 1}
+                        : clear_cursor{"stats"_n, 0};
+    }
+    max_rows = 0;
+  }
+  if (cursor.table == "stats"_n) {
+    stat_index stats(get_self(), get_self().value);
+    _clear_table(stats, cursor, max_rows, name(), skip);
+  }
+
+  if (cursor.table == name()) {
+    cursor_table.remove();
+    print("done");
+  } else {
+    cursor_table.set(cursor, get_self());
+    print("remaining: ", cursor.table, " from id ", cursor.next_id);
+  }
+}
+
+ACTION cryptoart::clearscopes(vector<name> scopes) {
+  require_auth(get_self());
+  for (auto scope : scopes) {
+    account_index(get_self(), scope.value)
+        .truncate(0, numeric_limits<uint64_t>::max());
+    bid_qual(get_self(), scope.value)
+        .truncate(0, numeric_limits<uint64_t>::max());
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <eosio/native.hpp>
+
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Minimal test runner for the native tests.
+ *
+ * `TEST(name)` registers a case, `CHECK` records a failure and carries on,
+ * `CHECK_ASSERT` expects a failed contract check whose message contains the
+ * given text. Every case starts from an empty chain.
+ */
+namespace test {
+
+using case_fn = void (*)();
+
+inline std::vector<std::pair<const char *, case_fn>> &cases() {
+  static std::vector<std::pair<const char *, case_fn>> all;
+  return all;
+}
+
+inline int &failures() {
+  static int count = 0;
+  return count;
+}
+
+struct registrar {
+  registrar(const char *name, case_fn fn) { cases().emplace_back(name, fn); }
+};
+
+inline void fail(const char *file, int line, const std::string &what) {
+  std::fprintf(stderr, "%s:%d: %s\n", file, line, what.c_str());
+  failures()++;
+}
+
+inline int run_all() {
+  for (const auto &c : cases()) {
+    eosio::native::reset();
+    int before = failures();
+    try {
+      c.second();
+    } catch (const std::exception &e) {
+      fail(c.first, 0, std::string("unexpected exception: ") + e.what());
+    }
+    std::printf("%s %s\n", failures() == before ? "ok  " : "FAIL", c.first);
+  }
+  return failures() == 0 ? 0 : 1;
+}
+
+} // namespace test
+
+#define TEST(name)                                                             \
+  static void name();                                                          \
+  static test::registrar name##_registrar(#name, name);                        \
+  static void name()
+
+#define CHECK(expr)                                                            \
+  ((expr) ? void() : test::fail(__FILE__, __LINE__, "CHECK(" #expr ") failed"))
+
+#define CHECK_ASSERT(expr, text)                                               \
+  do {                                                                         \
+    try {                                                                      \
+      expr;                                                                    \
+      test::fail(__FILE__, __LINE__, #expr " did not fail");                   \
+    } catch (const eosio::native::assert_failure &e) {                         \
+      if (std::string(e.what()).find(text) == std::string::npos)               \
+        test::fail(__FILE__, __LINE__,                                         \
+                   std::string(#expr " failed with: ") + e.what());            \
+    }                                                                          \
+  } while (0)